@@ -1,4 +1,5 @@
 #include "cli_command.h"
+#include <metrics.h>
 
 // Define the static group names
 
@@ -15,11 +16,109 @@ const char* CommandManager::GROUP_NAMES[] = {
 // Create global instance connected to the global CLI instance
 CommandManager Commands(CLI);
 
+// Serialization buffers for JSON responses, one per core
+char CommandManager::s_jsonBuffer[portNUM_PROCESSORS][CMD_JSON_BUFFER_SIZE];
+
+const char* CommandManager::interfaceName(OutputInterface interface) {
+    switch (interface) {
+        case OutputInterface::serial:
+            return "SERIAL";
+        case OutputInterface::telnet:
+            return "TELNET";
+        case OutputInterface::BOTH:
+            return "BOTH";
+    }
+    return "UNKNOWN";
+}
+
+/*
+* Per command dispatch counters, read from the CLI command table at render time
+*/
+class CommandCountMetric : public Metric {
+    public:
+        CommandCountMetric() : Metric("cli_commands_total", "Commands dispatched", MetricType::COUNTER) {}
+        void render(Print& out) const override {
+            char line[96];
+            renderHeader(out);
+            for (const auto& cmd : CLI.getCommands()) {
+                int len = snprintf(line, sizeof(line), "%s{command=\"%s\"} %u\n",
+                                   name, cmd.command.c_str(), (unsigned)cmd.calls);
+                out.write(reinterpret_cast<const uint8_t*>(line), len < (int)sizeof(line) ? len : sizeof(line) - 1);
+            }
+            int len = snprintf(line, sizeof(line), "%s{command=\"unknown\"} %u\n",
+                               name, (unsigned)CLI.getUnknownCommands());
+            out.write(reinterpret_cast<const uint8_t*>(line), len);
+        }
+};
+static CommandCountMetric s_commandCount;
+
+/*
+* Hit and miss counters of the command response caches
+*/
+class ResponseCacheMetric : public Metric {
+    public:
+        ResponseCacheMetric() : Metric("cli_response_cache_total", "Cached command responses replayed or rendered", MetricType::COUNTER) {}
+        void render(Print& out) const override {
+            char line[96];
+            renderHeader(out);
+            for (uint8_t i = 0; i < static_cast<uint8_t>(CachedResponse::COUNT); i++) {
+                uint32_t hits = 0;
+                uint32_t misses = 0;
+                for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+                    const ResponseCache& cache = Commands.getCache(static_cast<CachedResponse>(i), core);
+                    hits += cache.getHits();
+                    misses += cache.getMisses();
+                }
+                const char* cache = Commands.getCache(static_cast<CachedResponse>(i), 0).name;
+                int len = snprintf(line, sizeof(line), "%s{cache=\"%s\",result=\"hit\"} %u\n%s{cache=\"%s\",result=\"miss\"} %u\n",
+                                   name, cache, (unsigned)hits, name, cache, (unsigned)misses);
+                out.write(reinterpret_cast<const uint8_t*>(line), len < (int)sizeof(line) ? len : sizeof(line) - 1);
+            }
+        }
+};
+static ResponseCacheMetric s_cacheMetric;
+
+static const char* CACHE_NAMES[] = {
+    "help",
+    "info",
+    "info_detail",
+    "info_json",
+    "info_detail_json"
+};
+
+#if CLI_GROUP_SYSTEM || CLI_GROUP_NETWORK
+static void formatIP(char* buf, size_t size, const IPAddress& ip) {
+    snprintf(buf, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+// Add the "wifi" object shared by status and wifi status
+void CommandManager::addWifiJson(JsonWriter& json, const SystemSnapshot& state) {
+    json.beginObject("wifi");
+    json.add("connected", state.connected);
+    if (state.connected) {
+        char ip[16];
+        formatIP(ip, sizeof(ip), IPAddress(state.ip));
+        json.add("ssid", state.ssid);
+        json.add("ip", ip);
+        json.add("rssi", (int)state.rssi);
+        json.add("channel", (unsigned)state.channel);
+    }
+    json.endObject();
+}
+#endif
+
+CommandManager::CommandManager(ESP32_CLI& cliRef) : m_cli(cliRef) {
+    for (auto& caches : _caches) {
+        for (uint8_t i = 0; i < static_cast<uint8_t>(CachedResponse::COUNT); i++) {
+            caches[i].name = CACHE_NAMES[i];
+        }
+    }
+}
+
 void CommandManager::begin() {
     // Register built-in commands
     _commands.clear(); // Clear any existing commands
-    //debug message
-    cliPrintln("Registering built-in commands...");
+    CLI_LOGD(CLI, "Registering built-in commands");
 
     registerBuiltinCommands();
     cliPrintln("Type 'help' for available commands");
@@ -37,8 +136,11 @@ bool CommandManager::registerCommand(const CommandAdvanced& command)
     }
     //add to internal command list
     _commands.push_back(command);
+    for (auto& caches : _caches) {
+        caches[static_cast<uint8_t>(CachedResponse::HELP)].invalidate();
+    }
     //Register withe the CLI system
-    m_cli.addCommand(command.command, command.description, command.callback);
+    m_cli.addCommand(command.command, command.description, command.callback, command.appContext);
     return true;
 }
 
@@ -126,14 +228,10 @@ int CommandManager::showGroupCommands(CommandGroup group) {
     for (const auto& cmd : _commands) {
         // check command is linked to the specific group
         if (cmd.group == group) {
-            cliPrint("  ");
-            cliPrint(cmd.command);
-            // Add padding to align descriptions
-            for (size_t i = cmd.command.length(); i < 15; i++) {
-                cliPrint(" ");
-            }
-            cliPrint("- ");
-            cliPrintln(cmd.description);
+            // Pad the name to align descriptions
+            char line[128];
+            snprintf(line, sizeof(line), "  %-15s- %s", cmd.command.c_str(), cmd.description.c_str());
+            cliPrintln(line);
             count++;
         }
     }
@@ -143,9 +241,18 @@ int CommandManager::showGroupCommands(CommandGroup group) {
     return count;
 }
 
+int CommandManager::countGroupCommands(CommandGroup group) {
+    int count = 0;
+    for (const auto& cmd : _commands) {
+        if (cmd.group == group) {
+            count++;
+        }
+    }
+    return count;
+}
+
 void CommandManager::registerBuiltinCommands(){
     //Help command
-
     registerCommand(CommandAdvanced(
         "help", 
         "List all available commands",
@@ -155,86 +262,50 @@ void CommandManager::registerBuiltinCommands(){
          1,2
     ));
 
-    //Status command
-    registerCommand(CommandAdvanced(
-        "status", 
-        "Show system status",
-         [this](const std::vector<String>& args) {cmdStatus(args);},
-         "status",
-         CommandGroup::SYSTEM,
-         1,1
-    ));
-    
-    //Info command
-    registerCommand(CommandAdvanced(
-        "info", 
-        "Show system information",
-         [this](const std::vector<String>& args) {cmdInfo(args);},
-         "info [detail]",
-         CommandGroup::SYSTEM,
-         1,22
-    ));
-
-    // Restart command
-    registerCommand(CommandAdvanced(
-        "restart",
-        "Restart the ESP32",
-        [this](const std::vector<String>& args) { cmdRestart(args); },
-        "restart",
-        CommandGroup::SYSTEM,
-        1, 1
-    ));
-    
-    // Memory command
-    registerCommand(CommandAdvanced(
-        "memory",
-        "Show memory usage",
-        [this](const std::vector<String>& args) { cmdMemory(args); },
-        "memory",
-        CommandGroup::SYSTEM,
-        1, 1
-    ));
-    
-    // WiFi command
-    registerCommand(CommandAdvanced(
-        "wifi",
-        "WiFi operations and information",
-        [this](const std::vector<String>& args) { cmdWifi(args); },
-        "wifi <status|scan|connect|disconnect>",
-        CommandGroup::NETWORK,
-        2, 4
-    ));
-    
-    // GPIO command
-    registerCommand(CommandAdvanced(
-        "gpio",
-        "Control GPIO pins",
-        [this](const std::vector<String>& args) { cmdGPIO(args); },
-        "gpio <pin> <read|set|clear|toggle>",
-        CommandGroup::PERIPHERALS,
-        3, 3
-    ));
-    
     // Interface command
     registerCommand(CommandAdvanced(
         "interface",
-        "Change output interface (serial/telnet/both)",
+        "Change default output interface (serial/telnet/both)",
         [this](const std::vector<String>& args) { cmdInterface(args); },
         "interface [serial|telnet|both]",
         CommandGroup::GENERAL,
         1, 2
     ));
 
-    //Read sensor data
+    // Subscribe command
+    registerCommand(CommandAdvanced(
+        "subscribe",
+        "Receive broadcast output in this session",
+        [this](const std::vector<String>& args) { cmdSubscribe(args); },
+        "subscribe [log|debug <on|off>]",
+        CommandGroup::GENERAL,
+        1, 3,
+        true
+    ));
+
+    // Format command
     registerCommand(CommandAdvanced(
-        "read",
-        "Read sensor data",
-        [this](const std::vector<String>& args) {cmdReadSensor(args);},
-        "read adc",
-        CommandGroup::PERIPHERALS,
-        2, 2
+        "format",
+        "Set output format of this session (text/json)",
+        [this](const std::vector<String>& args) { cmdFormat(args); },
+        "format [text|json]",
+        CommandGroup::GENERAL,
+        1, 2
     ));
 
+    // Optional groups, selected with the CLI_GROUP_* build flags
+#if CLI_GROUP_SYSTEM
+    registerSystemCommands();
+#endif
+#if CLI_GROUP_NETWORK
+    registerNetworkCommands();
+#endif
+#if CLI_GROUP_PERIPHERALS
+    registerPeripheralsCommands();
+#endif
+#if CLI_GROUP_DEBUG
+    registerDebugCommands();
+#endif
 }
 void CommandManager::cliPrintln(const String& text) {
     m_cli.println(text);
@@ -244,6 +315,41 @@ void CommandManager::cliPrint(const String& text) {
     m_cli.print(text);
 }
 
+void CommandManager::cliWriteJson(const JsonWriter& json) {
+    if (json.overflowed()) {
+        // Truncated output is not valid JSON, pollers get an error object.
+        // Nothing else is written: without a debug subscriber a log line
+        // would land on this sink (or in a response cache) ahead of it
+        static const char OVERFLOW_ERROR[] = "{\"error\":\"response too large\"}\r\n";
+        m_cli.write(OVERFLOW_ERROR, sizeof(OVERFLOW_ERROR) - 1);
+        return;
+    }
+    m_cli.write(json.c_str(), json.length());
+    m_cli.write("\r\n", 2);
+}
+
+// Replay a cached response, rendering it through a capture sink on a miss
+void CommandManager::writeCached(CachedResponse which, std::function<void()> render) {
+    const String& text = renderCached(which, render);
+    m_cli.write(text.c_str(), text.length());
+}
+
+// Cached response text, rendered on a miss, for callers adding live parts
+const String& CommandManager::renderCached(CachedResponse which, std::function<void()> render) {
+    ResponseCache& cache = _caches[xPortGetCoreID()][static_cast<uint8_t>(which)];
+    if (!cache.lookup()) {
+        String& text = cache.store();
+        StringSink capture(text);
+        OutputSink* sink = m_cli.getCurrentSink();
+        capture.format = sink != nullptr ? sink->format : OutputFormat::text;
+        OutputSink* prev = m_cli.redirect(&capture);
+        render();
+        m_cli.redirect(prev);
+        cache.commit();
+    }
+    return cache.text();
+}
+
 //---------- Command Implementations ----------
 
 void CommandManager::cmdHelp(const std::vector<String>& args) {
@@ -254,224 +360,56 @@ void CommandManager::cmdHelp(const std::vector<String>& args) {
             cliPrintln(args[1]);
         }
     } else {
-        // Show all command groups
-        for (int i = 0; i <= static_cast<int>(CommandGroup::USER); i++) {
-            showGroupCommands(static_cast<CommandGroup>(i));
-        }
-    }
-}
-void CommandManager::cmdStatus(const std::vector<String>& args) {
-    
-    cliPrintln("--- System Status ---");
-    // WiFi status
-    cliPrint("WiFi: ");
-    cliPrint(WiFi.status() == WL_CONNECTED ? "Connected to " : "Disconnected");
-    if (WiFi.status() == WL_CONNECTED) {
-      cliPrintln(WiFi.SSID());
-      cliPrint("IP: ");
-      cliPrintln(WiFi.localIP().toString());
-      cliPrint("Signal: ");
-      cliPrint(String(WiFi.RSSI()));
-      cliPrintln(" dBm");
-    } else {
-      cliPrintln("");
-    }
-    
-    // Time
-    char timeStr[20];
-    sprintf(timeStr, "%02d-%02d-%02d %02d:%02d:%02d", 
-            year(), month(), day(), hour(), minute(), second());
-    cliPrint("Current time: ");
-    cliPrintln(timeStr);
-    
-    // Memory
-    cliPrint("Free heap: ");
-    cliPrint(String(ESP.getFreeHeap()));
-    cliPrintln(" bytes");
-    
-    // Telnet status
-    //TODO: check if TelnetStream is connected
-    // cliPrint("Telnet client: ");
-    // cliPrintln(CLI.isClientConnected() ? "Connected" : "Not connected");
-    
-    // Current interface
-    cliPrint("Current interface: ");
-    switch (CLI.getCurrentInterface()) {
-      case OutputInterface::serial:
-        cliPrintln("SERIAL");
-        break;
-      case OutputInterface::telnet:
-        cliPrintln("TELNET");
-        break;
-      case OutputInterface::BOTH:
-        cliPrintln("BOTH");
-        break;
-    }
-}
-void CommandManager::cmdInfo(const std::vector<String>& args) {
-    cliPrintln("ESP32 System Information:");
-    cliPrint("- Chip model: ");
-    cliPrintln(ESP.getChipModel());
-    cliPrint("- Chip cores: ");
-    cliPrintln(String(ESP.getChipCores()));
-    cliPrint("- CPU frequency: ");
-    cliPrint(String(ESP.getCpuFreqMHz()));
-    cliPrintln(" MHz");
-    cliPrint("- Flash size: ");
-    cliPrint(String(ESP.getFlashChipSize() / 1024 / 1024));
-    cliPrintln(" MB");
-    cliPrint("- SDK version: ");
-    cliPrintln(ESP.getSdkVersion());
-    
-    if (args.size() > 1 && args[1].equalsIgnoreCase("detail")) {
-        cliPrintln("\nDetailed Information:");
-        cliPrint("- Heap size: ");
-        cliPrint(String(ESP.getHeapSize() / 1024));
-        cliPrintln(" KB");
-        cliPrint("- MAC address: ");
-        cliPrintln(WiFi.macAddress());
-        cliPrint("- Sketch size: ");
-        cliPrint(String(ESP.getSketchSize() / 1024));
-        cliPrintln(" KB");
-        cliPrint("- Free sketch space: ");
-        cliPrint(String(ESP.getFreeSketchSpace() / 1024));
-        cliPrintln(" KB");
+        writeCached(CachedResponse::HELP, [this]() { showAllGroups(); });
     }
 }
 
-void CommandManager::cmdRestart(const std::vector<String>& args) {
-    cliPrintln("Restarting ESP32...");
-    delay(500);
-    ESP.restart();
-}
-
-// Implement the remaining command handlers...
-void CommandManager::cmdMemory(const std::vector<String>& args) {
-    cliPrintln("Memory Information:");
-    cliPrint("- Free heap: ");
-    cliPrint(String(ESP.getFreeHeap() / 1024));
-    cliPrintln(" KB");
-    cliPrint("- Heap size: ");
-    cliPrint(String(ESP.getHeapSize() / 1024));
-    cliPrintln(" KB");
-    cliPrint("- Min free heap: ");
-    cliPrint(String(ESP.getMinFreeHeap() / 1024));
-    cliPrintln(" KB");
-    cliPrint("- Max alloc heap: ");
-    cliPrint(String(ESP.getMaxAllocHeap() / 1024));
-    cliPrintln(" KB");
+void CommandManager::showAllGroups() {
+    // Show the groups that have commands in this build
+    for (int i = 0; i <= static_cast<int>(CommandGroup::USER); i++) {
+        CommandGroup group = static_cast<CommandGroup>(i);
+        if (countGroupCommands(group) > 0) {
+            showGroupCommands(group);
+        }
+    }
 }
 
-void CommandManager::cmdWifi(const std::vector<String>& args) {
-    if (args.size() < 2) {
-        cliPrintln("Usage: wifi <status|scan|connect|disconnect>");
-        return;
-    }
-    
-    if (args[1].equalsIgnoreCase("status")) {
-        cliPrintln("WiFi Status:");
-        if (WiFi.status() == WL_CONNECTED) {
-            cliPrintln("- Status: Connected");
-            cliPrint("- SSID: ");
-            cliPrintln(WiFi.SSID());
-            cliPrint("- IP address: ");
-            cliPrintln(WiFi.localIP().toString());
-            cliPrint("- Signal strength: ");
-            cliPrint(String(WiFi.RSSI()));
-            cliPrintln(" dBm");
-        } else {
-            cliPrintln("- Status: Disconnected");
-        }
-    } else if (args[1].equalsIgnoreCase("scan")) {
-        cliPrintln("Scanning for WiFi networks...");
-        int networks = WiFi.scanNetworks();
-        
-        if (networks == 0) {
-            cliPrintln("No networks found");
-        } else {
-            cliPrint(String(networks));
-            cliPrintln(" networks found:");
-            
-            for (int i = 0; i < networks; i++) {
-                cliPrint(String(i + 1));
-                cliPrint(": ");
-                cliPrint(WiFi.SSID(i));
-                cliPrint(" (");
-                cliPrint(String(WiFi.RSSI(i)));
-                cliPrint(" dBm) ");
-                cliPrintln((WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted");
-                delay(10);
-            }
-        }
-        
-        WiFi.scanDelete();
-    } else if (args[1].equalsIgnoreCase("connect") && args.size() >= 4) {
-        cliPrint("Connecting to: ");
-        cliPrintln(args[2]);
-        
-        WiFi.begin(args[2].c_str(), args[3].c_str());
-        
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            cliPrint(".");
-            attempts++;
-        }
-        cliPrintln("");
-        
-        if (WiFi.status() == WL_CONNECTED) {
-            cliPrintln("Connected successfully!");
-            cliPrint("IP address: ");
-            cliPrintln(WiFi.localIP().toString());
+void CommandManager::cmdFormat(const std::vector<String>& args) {
+    if (args.size() > 1) {
+        if (args[1].equalsIgnoreCase("text")) {
+            m_cli.setFormat(OutputFormat::text);
+        } else if (args[1].equalsIgnoreCase("json")) {
+            m_cli.setFormat(OutputFormat::json);
         } else {
-            cliPrintln("Failed to connect");
+            cliPrintln("Invalid format. Use: text or json");
+            return;
         }
-    } else if (args[1].equalsIgnoreCase("disconnect")) {
-        WiFi.disconnect();
-        cliPrintln("WiFi disconnected");
-    } else {
-        cliPrintln("Unknown WiFi command");
     }
+    cliPrint("Output format: ");
+    cliPrintln(m_cli.getFormat() == OutputFormat::json ? "JSON" : "TEXT");
 }
 
-void CommandManager::cmdGPIO(const std::vector<String>& args) {
-    if (args.size() < 3) {
-        cliPrintln("Usage: gpio <pin> <read|set|clear|toggle>");
-        return;
-    }
-    
-    int pin = args[1].toInt();
-    if (pin < 0 || pin > 39) {
-        cliPrintln("Invalid pin number. Use 0-39");
+void CommandManager::cmdSubscribe(const std::vector<String>& args) {
+    OutputSink* sink = m_cli.getCurrentSink();
+    if (sink == nullptr) {
         return;
     }
-    
-    if (args[2].equalsIgnoreCase("read")) {
-        cliPrint("GPIO ");
-        cliPrint(String(pin));
-        cliPrint(" value: ");
-        pinMode(pin, INPUT);
-        cliPrintln(String(digitalRead(pin)));
-    } else if (args[2].equalsIgnoreCase("set")) {
-        cliPrint("Setting GPIO ");
-        cliPrint(String(pin));
-        cliPrintln(" HIGH");
-        pinMode(pin, OUTPUT);
-        digitalWrite(pin, HIGH);
-    } else if (args[2].equalsIgnoreCase("clear")) {
-        cliPrint("Setting GPIO ");
-        cliPrint(String(pin));
-        cliPrintln(" LOW");
-        pinMode(pin, OUTPUT);
-        digitalWrite(pin, LOW);
-    } else if (args[2].equalsIgnoreCase("toggle")) {
-        cliPrint("Toggling GPIO ");
-        cliPrintln(String(pin));
-        pinMode(pin, OUTPUT);
-        digitalWrite(pin, !digitalRead(pin));
-    } else {
-        cliPrintln("Unknown GPIO operation. Use read, set, clear, or toggle");
+    if (args.size() > 2) {
+        Topic topic;
+        if (args[1].equalsIgnoreCase("log")) {
+            topic = Topic::SENSOR_LOG;
+        } else if (args[1].equalsIgnoreCase("debug")) {
+            topic = Topic::DEBUG_LOG;
+        } else {
+            cliPrintln("Unknown topic. Use: log, debug");
+            return;
+        }
+        m_cli.subscribe(sink, topic, args[2].equalsIgnoreCase("on"));
     }
+    cliPrint("Sensor log: ");
+    cliPrintln((sink->subscriptions & TOPIC_BIT(Topic::SENSOR_LOG)) ? "on" : "off");
+    cliPrint("Debug log: ");
+    cliPrintln((sink->subscriptions & TOPIC_BIT(Topic::DEBUG_LOG)) ? "on" : "off");
 }
 
 void CommandManager::cmdInterface(const std::vector<String>& args) {
@@ -488,26 +426,6 @@ void CommandManager::cmdInterface(const std::vector<String>& args) {
     } else {
         // Show current interface
         cliPrint("Current interface: ");
-        switch (m_cli.getCurrentInterface()) {
-            case OutputInterface::serial:
-                cliPrintln("SERIAL");
-                break;
-            case OutputInterface::telnet:
-                cliPrintln("TELNET");
-                break;
-            case OutputInterface::BOTH:
-                cliPrintln("BOTH");
-                break;
-        }
+        cliPrintln(interfaceName(m_cli.getCurrentInterface()));
     }
 }
-
-void CommandManager::cmdReadSensor(const std::vector<String>& args) {
-    if (args.size() > 1 && args[1].equalsIgnoreCase("adc")) {
-        int value = analogRead(A0);
-        cliPrint("ADC value: ");
-        cliPrintln(String(value));
-    } else {
-        cliPrintln("Usage: read adc");
-    }
-}
\ No newline at end of file
@@ -7,12 +7,52 @@
 #include <vector>
 #include <functional>
 #include <cli.h>
+#include <json_writer.h>
+#include <response_cache.h>
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <cli_log.h>
+
+// Command groups compiled into the firmware, drop one with -DCLI_GROUP_<NAME>=0.
+// General commands (help, interface, subscribe, format) are always built in.
+#ifndef CLI_GROUP_SYSTEM
+#define CLI_GROUP_SYSTEM       1
+#endif
+#ifndef CLI_GROUP_NETWORK
+#define CLI_GROUP_NETWORK      1
+#endif
+#ifndef CLI_GROUP_PERIPHERALS
+#define CLI_GROUP_PERIPHERALS  1
+#endif
+#ifndef CLI_GROUP_DEBUG
+#define CLI_GROUP_DEBUG        1
+#endif
+
+#if CLI_GROUP_SYSTEM || CLI_GROUP_NETWORK
+#include <system_state.h>
+#endif
+#if CLI_GROUP_PERIPHERALS
+#include <edge_capture.h>
+#endif
 
 // Error message constants
 #define CMD_MSG_INVALID_ARGS   "Error: Invalid arguments"
 #define CMD_MSG_EXEC_ERROR     "Error: Command execution failed"
 #define CMD_MSG_NO_ACCESS      "Error: Permission denied"
 
+// Size of the buffer JSON responses are serialized into
+#define CMD_JSON_BUFFER_SIZE   512
+
+// Cached responses of commands with static output
+enum class CachedResponse : uint8_t {
+    HELP = 0,
+    INFO,           // Summary part of 'info'
+    INFO_DETAIL,    // Detail part of 'info detail'
+    INFO_JSON,
+    INFO_DETAIL_JSON,
+    COUNT
+};
+
 /*
 * Command result codes
 */
@@ -47,8 +87,9 @@ class CommandAdvanced: public Command {
         // const String& usage = "", CommandGroup group = CommandGroup::GENERAL, uint8_t min_args = 0, uint8_t max_args = 0) 
         // : Command(cmd,description,callback)command(cmd), description(description), callback(callback), usage(usage), group(group), min_args(min_args), max_args(max_args) {}        
         CommandAdvanced(const String& cmd, const String& description, std::function<void(const std::vector<String>&)> callback, 
-            const String& usage = "", CommandGroup group = CommandGroup::GENERAL, uint8_t min_args = 0, uint8_t max_args = 0) 
-        : Command(cmd,description,callback), usage(usage), group(group), min_args(min_args), max_args(max_args) {}
+            const String& usage = "", CommandGroup group = CommandGroup::GENERAL, uint8_t min_args = 0, uint8_t max_args = 0,
+            bool appContext = false) 
+        : Command(cmd,description,callback,appContext), usage(usage), group(group), min_args(min_args), max_args(max_args) {}
 };
 class CommandManager {
     public:
@@ -56,7 +97,7 @@ class CommandManager {
          * Constructor that accepts a reference to the CLI instance
          * @param cliRef Reference to the CLI instance
          */
-        CommandManager(ESP32_CLI& cliRef) : m_cli(cliRef) {};
+        CommandManager(ESP32_CLI& cliRef);
         /**
          * Initialize the command manager
          */
@@ -89,6 +130,13 @@ class CommandManager {
          * @return Number of commands shown
          */
         int showGroupCommands(CommandGroup group);
+
+        /**
+         * Count the registered commands of a group
+         * @param group Command group
+         * @return Number of commands in the group
+         */
+        int countGroupCommands(CommandGroup group);
         
         /**
          * Get group name as string
@@ -111,21 +159,113 @@ class CommandManager {
          * Inteface cli print function
          */
         void cliPrint(const String& text);
+
+        /**
+         * Write a serialized JSON response followed by a line break
+         */
+        void cliWriteJson(const JsonWriter& json);
+
+        /**
+         * Response cache of one core, for hit/miss statistics
+         */
+        inline const ResponseCache& getCache(CachedResponse which, uint8_t core) const { return _caches[core][static_cast<uint8_t>(which)]; }
         
     private:
         ESP32_CLI& m_cli;  // Pointer to the CLI instance
         std::vector<CommandAdvanced> _commands;
+        // In task mode handlers run on both cores (CLI task, and loop() for
+        // watch and application context commands): each core renders into
+        // its own caches and JSON buffer
+        ResponseCache _caches[portNUM_PROCESSORS][static_cast<uint8_t>(CachedResponse::COUNT)];
         static const char* GROUP_NAMES[];
-        // Built-in command handlers
+        static char s_jsonBuffer[portNUM_PROCESSORS][CMD_JSON_BUFFER_SIZE];
+        static inline char* jsonBuffer() { return s_jsonBuffer[xPortGetCoreID()]; }
+        static const char* interfaceName(OutputInterface interface);
+#if CLI_GROUP_SYSTEM || CLI_GROUP_NETWORK
+        static void addWifiJson(JsonWriter& json, const SystemSnapshot& state);
+#endif
+
+        void writeCached(CachedResponse which, std::function<void()> render);
+        const String& renderCached(CachedResponse which, std::function<void()> render);
+
+        // General commands, always built in
         void cmdHelp(const std::vector<String>& args);
+        void showAllGroups();
+        void cmdInterface(const std::vector<String>& args);
+        void cmdFormat(const std::vector<String>& args);
+        void cmdSubscribe(const std::vector<String>& args);
+
+#if CLI_GROUP_SYSTEM
+        // cmd_system.cpp
+        void registerSystemCommands();
         void cmdInfo(const std::vector<String>& args);
         void cmdStatus(const std::vector<String>& args);
         void cmdRestart(const std::vector<String>& args);
         void cmdMemory(const std::vector<String>& args);
+        void memoryMap(const std::vector<String>& args);
+        void memoryTrace(const std::vector<String>& args);
+        void cmdTransfer(const std::vector<String>& args);
+        void statusJson();
+        void cmdState(const std::vector<String>& args);
+        void infoText();
+        void infoDetailText();
+        void infoJson(bool detail);
+#endif
+
+#if CLI_GROUP_NETWORK
+        // cmd_network.cpp
+        void registerNetworkCommands();
         void cmdWifi(const std::vector<String>& args);
+#endif
+
+#if CLI_GROUP_PERIPHERALS
+        // cmd_peripherals.cpp
+        void registerPeripheralsCommands();
         void cmdGPIO(const std::vector<String>& args);
-        void cmdInterface(const std::vector<String>& args);
+        void gpioMask(const std::vector<String>& args);
+        void gpioWave(const std::vector<String>& args);
+        void gpioBench(const std::vector<String>& args);
+        void gpioWatch(const std::vector<String>& args);
+        void printEdgeStat(const char* label, const EdgeStat& stat);
         void cmdReadSensor(const std::vector<String>& args);
+        void cmdSensor(const std::vector<String>& args);
+
+        // read adc stream state: one sample per scheduler tick
+        int _streamTask = -1;
+        OutputSink* _streamSink = nullptr;
+        void stopStream();
+        void runStream();
+#endif
+
+#if CLI_GROUP_DEBUG
+        // cmd_debug.cpp
+        void registerDebugCommands();
+        void cmdLog(const std::vector<String>& args);
+        void cmdMetrics(const std::vector<String>& args);
+        void cmdCliTask(const std::vector<String>& args);
+        void cmdIdle(const std::vector<String>& args);
+        void cmdTop(const std::vector<String>& args);
+        void cmdWatch(const std::vector<String>& args);
+
+        // watch state: the command is resolved once and re-run from the scheduler
+        int _watchTask = -1;
+        bool _watchDiff = false;
+        bool _watchJson = false;    // "--json" applies to every run, not just the first
+        std::function<void(const std::vector<String>&)> _watchCallback;
+        std::vector<String> _watchArgs;
+        String _watchOutput;
+        uint32_t _watchPeriod = 0;
+        OutputSink* _watchSink = nullptr;
+        void stopWatch();
+        void runWatch();
+
+        // top state: refreshed from the scheduler
+        int _topTask = -1;
+        OutputSink* _topSink = nullptr;
+        void stopTop();
+        void runTop();
+        void printTooManyTasks();
+#endif
 };
 
 // Global instance
@@ -0,0 +1,427 @@
+#include "cli_command.h"
+
+#if CLI_GROUP_DEBUG
+
+#include <scheduler.h>
+#include <metrics.h>
+#include <idle.h>
+#include <task_monitor.h>
+
+void CommandManager::registerDebugCommands() {
+    // Log level command
+    registerCommand(CommandAdvanced(
+        "log",
+        "Show or set log levels per module",
+        [this](const std::vector<String>& args) { cmdLog(args); },
+        "log [<module>|all <none|error|warn|info|debug|verbose>]",
+        CommandGroup::DEBUG,
+        1, 3,
+        true
+    ));
+
+    // Metrics command
+    registerCommand(CommandAdvanced(
+        "metrics",
+        "Show metrics in Prometheus text format",
+        [this](const std::vector<String>& args) { cmdMetrics(args); },
+        "metrics",
+        CommandGroup::DEBUG,
+        1, 1,
+        true
+    ));
+
+    // Watch command
+    registerCommand(CommandAdvanced(
+        "watch",
+        "Re-run a command periodically",
+        [this](const std::vector<String>& args) { cmdWatch(args); },
+        "watch -n <ms> [-d] <command...> | watch stop",
+        CommandGroup::DEBUG,
+        1, 32,
+        true
+    ));
+
+    // Idle statistics command
+    registerCommand(CommandAdvanced(
+        "idle",
+        "Show idle time and wake-up latency of loop()",
+        [this](const std::vector<String>& args) { cmdIdle(args); },
+        "idle [reset|sleep <on|off>]",
+        CommandGroup::DEBUG,
+        1, 3,
+        true
+    ));
+
+    // Task monitor command
+    registerCommand(CommandAdvanced(
+        "top",
+        "Show CPU load, state and stack of FreeRTOS tasks",
+        [this](const std::vector<String>& args) { cmdTop(args); },
+        "top [interval_ms] | top stop",
+        CommandGroup::DEBUG,
+        1, 2,
+        true
+    ));
+
+    // CLI task command
+    registerCommand(CommandAdvanced(
+        "clitask",
+        "Show CLI task mode and cross-core dispatch latency",
+        [this](const std::vector<String>& args) { cmdCliTask(args); },
+        "clitask",
+        CommandGroup::DEBUG,
+        1, 1
+    ));
+}
+
+/*
+* Print adapter writing through the CLI output routing
+*/
+class CliPrint : public Print {
+    public:
+        CliPrint(ESP32_CLI& cli) : _cli(cli) {}
+        size_t write(uint8_t c) override {
+            _cli.write(reinterpret_cast<const char*>(&c), 1);
+            return 1;
+        }
+        size_t write(const uint8_t* data, size_t size) override {
+            _cli.write(reinterpret_cast<const char*>(data), size);
+            return size;
+        }
+    private:
+        ESP32_CLI& _cli;
+};
+
+void CommandManager::cmdMetrics(const std::vector<String>& args) {
+    CliPrint out(m_cli);
+    Metrics.render(out);
+}
+
+void CommandManager::cmdLog(const std::vector<String>& args) {
+    if (args.size() == 3) {
+        uint8_t level;
+        if (!Log.parseLevel(args[2], level)) {
+            cliPrintln("Unknown level. Use: none, error, warn, info, debug, verbose");
+            return;
+        }
+        if (args[1].equalsIgnoreCase("all")) {
+            for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); i++) {
+                Log.setLevel(static_cast<LogModule>(i), level);
+            }
+        } else {
+            LogModule module;
+            if (!Log.parseModule(args[1], module)) {
+                cliPrintln("Unknown module");
+                return;
+            }
+            Log.setLevel(module, level);
+        }
+    } else if (args.size() == 2) {
+        cliPrintln("Usage: log [<module>|all <level>]");
+        return;
+    }
+
+    char line[48];
+    snprintf(line, sizeof(line), "Compiled in up to: %s", Logger::levelName(CLI_LOG_LEVEL));
+    cliPrintln(line);
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); i++) {
+        LogModule module = static_cast<LogModule>(i);
+        snprintf(line, sizeof(line), "  %-8s %s", Logger::moduleName(module), Logger::levelName(Log.getLevel(module)));
+        cliPrintln(line);
+    }
+}
+
+void CommandManager::cmdCliTask(const std::vector<String>& args) {
+    if (!m_cli.isTaskMode()) {
+        cliPrintln("CLI runs in loop() (build with -DCLI_TASK_CORE=<core> for a dedicated task)");
+        return;
+    }
+    cliPrint("CLI task on core ");
+    cliPrint(String((int)m_cli.getTaskCore()));
+    cliPrint(", application loop on core ");
+    cliPrintln(String(CONFIG_ARDUINO_RUNNING_CORE));
+    cliPrint("- Application commands: ");
+    cliPrintln(String(m_cli.getAppDispatches()));
+    if (m_cli.getAppDispatches() > 0) {
+        cliPrint("- Dispatch latency: ");
+        cliPrint(String(m_cli.getAppLatencyMin()));
+        cliPrint(" / ");
+        cliPrint(String(m_cli.getAppLatencyMean()));
+        cliPrint(" / ");
+        cliPrint(String(m_cli.getAppLatencyMax()));
+        cliPrintln(" us (min/mean/max)");
+    }
+    cliPrint("- Application timeouts: ");
+    cliPrintln(String(m_cli.getAppTimeouts()));
+    cliPrint("- Broadcasts dropped while the CLI task wrote: ");
+    cliPrintln(String(m_cli.getDroppedBroadcasts()));
+}
+
+void CommandManager::cmdIdle(const std::vector<String>& args) {
+    if (args.size() > 1 && args[1].equalsIgnoreCase("reset")) {
+        Idle.resetStats();
+        cliPrintln("Idle statistics reset");
+        return;
+    }
+    if (args.size() > 2 && args[1].equalsIgnoreCase("sleep")) {
+        if (!Idle.setLightSleep(args[2].equalsIgnoreCase("on"))) {
+            cliPrintln("Light sleep not available (framework built without CONFIG_PM_ENABLE)");
+            return;
+        }
+    }
+
+    char line[80];
+    snprintf(line, sizeof(line), "Idle: %.1f%% over %u s", Idle.getIdlePercent(), (unsigned)Idle.getStatsSeconds());
+    cliPrintln(line);
+    snprintf(line, sizeof(line), "Wake-ups: %u event, %u timer",
+             (unsigned)Idle.getEventWakes(), (unsigned)Idle.getTimerWakes());
+    cliPrintln(line);
+    snprintf(line, sizeof(line), "Event latency: min %u / mean %u / max %u us",
+             (unsigned)Idle.getLatencyMin(), (unsigned)Idle.getLatencyMean(), (unsigned)Idle.getLatencyMax());
+    cliPrintln(line);
+    snprintf(line, sizeof(line), "Timer lateness: mean %u / max %u us",
+             (unsigned)Idle.getLatenessMean(), (unsigned)Idle.getLatenessMax());
+    cliPrintln(line);
+    cliPrint("Light sleep: ");
+    cliPrintln(Idle.isLightSleep() ? "on" : "off");
+
+    // Every task run and socket poll is a wake-up: the chip sleeps at most
+    // this long at a time
+    uint32_t period = Sched.getShortestPeriod();
+    uint32_t poll = Idle.getBlockLimit();
+    char task[16] = "none";
+    if (period != UINT32_MAX) {
+        snprintf(task, sizeof(task), "%u ms", (unsigned)period);
+    }
+    snprintf(line, sizeof(line), "Longest sleep: %u ms (shortest task period %s, poll %u ms)",
+             (unsigned)(period < poll ? period : poll), task, (unsigned)poll);
+    cliPrintln(line);
+}
+
+void CommandManager::cmdTop(const std::vector<String>& args) {
+#if TASK_MONITOR_AVAILABLE
+    if (args.size() > 1 && args[1].equalsIgnoreCase("stop")) {
+        stopTop();
+        cliPrintln("top stopped");
+        return;
+    }
+    long period = args.size() > 1 ? args[1].toInt() : 2000;   // Signed, "top -1" must not wrap
+    if (period < 500) {
+        cliPrintln("Usage: top [interval_ms] (>= 500) | top stop");
+        return;
+    }
+
+    stopTop();
+    _topSink = m_cli.getCurrentSink();
+    _topTask = Sched.addTask(period, [this]() { runTop(); });
+    if (_topTask < 0) {
+        cliPrintln("No free scheduler slot");
+        return;
+    }
+    m_cli.holdOutput();
+    // The first sample only sets the baseline
+    Tasks.reset();
+    Tasks.sample();
+    if (Tasks.overflowed()) {
+        stopTop();
+        printTooManyTasks();
+        return;
+    }
+    cliPrintln("Sampling... ('top stop' ends)");
+#else
+    cliPrintln("Not available: FreeRTOS built without the trace facility");
+#endif
+}
+
+void CommandManager::stopTop() {
+    if (_topTask >= 0) {
+        Sched.removeTask(_topTask);
+        _topTask = -1;
+        m_cli.releaseOutput(_topSink);
+    }
+    _topSink = nullptr;
+}
+
+void CommandManager::runTop() {
+    if (m_cli.isOutputClosed(_topSink)) {
+        stopTop();
+        return;
+    }
+    if (!Tasks.sample()) {
+        if (Tasks.overflowed()) {
+            // Stays that way until tasks end, stop instead of freezing
+            OutputSink* prev = m_cli.redirect(_topSink);
+            printTooManyTasks();
+            m_cli.redirect(prev);
+            stopTop();
+        }
+        return;
+    }
+
+    static const char STATES[] = "RrBSD?";   // Running, ready, blocked, suspended, deleted
+    OutputSink* prev = m_cli.redirect(_topSink);
+    char line[80];
+    int len;
+
+    // Home and clear, so the table refreshes in place
+    m_cli.write("\x1b[H\x1b[2J", 7);
+#if TASK_MONITOR_CPU
+    len = snprintf(line, sizeof(line), "Tasks: %u  Core 0: %.1f%% busy  Core 1: %.1f%% busy  (%u ms)\r\n",
+                   (unsigned)Tasks.getCount(), Tasks.getCoreBusy(0), Tasks.getCoreBusy(1),
+                   (unsigned)(Tasks.getInterval() / 1000));
+    m_cli.write(line, len);
+    len = snprintf(line, sizeof(line), "%-16s %4s %4s %5s %6s %10s\r\n", "Task", "Core", "Prio", "State", "CPU%", "Stack free");
+#else
+    len = snprintf(line, sizeof(line), "Tasks: %u  (no run time statistics, CPU%% not shown)\r\n",
+                   (unsigned)Tasks.getCount());
+    m_cli.write(line, len);
+    len = snprintf(line, sizeof(line), "%-16s %4s %4s %5s %10s\r\n", "Task", "Core", "Prio", "State", "Stack free");
+#endif
+    m_cli.write(line, len);
+    for (uint8_t i = 0; i < Tasks.getCount(); i++) {
+        const TaskLoad& task = Tasks.getTask(i);
+        char core[4];
+        if (task.core < 0) {
+            strcpy(core, "-");
+        } else {
+            snprintf(core, sizeof(core), "%d", task.core);
+        }
+        char state = STATES[task.state < eInvalid ? task.state : eInvalid];
+#if TASK_MONITOR_CPU
+        len = snprintf(line, sizeof(line), "%-16s %4s %4u %5c %6.1f %10u\r\n",
+                       task.name, core, (unsigned)task.priority, state, task.cpu, (unsigned)task.stackFree);
+#else
+        len = snprintf(line, sizeof(line), "%-16s %4s %4u %5c %10u\r\n",
+                       task.name, core, (unsigned)task.priority, state, (unsigned)task.stackFree);
+#endif
+        m_cli.write(line, len);
+    }
+    m_cli.redirect(prev);
+}
+
+void CommandManager::printTooManyTasks() {
+    char line[64];
+    snprintf(line, sizeof(line), "Error: more than %u tasks, raise TASK_MONITOR_MAX_TASKS",
+             (unsigned)TASK_MONITOR_MAX_TASKS);
+    cliPrintln(line);
+}
+
+void CommandManager::cmdWatch(const std::vector<String>& args) {
+    if (args.size() < 2) {
+        if (_watchTask < 0) {
+            cliPrintln("No active watch");
+        } else {
+            cliPrint("Watching '");
+            cliPrint(_watchArgs[0]);
+            cliPrint("' every ");
+            cliPrint(String(_watchPeriod));
+            cliPrintln(_watchDiff ? " ms (changes only)" : " ms");
+        }
+        return;
+    }
+    if (args[1].equalsIgnoreCase("stop")) {
+        stopWatch();
+        cliPrintln("Watch stopped");
+        return;
+    }
+
+    // Parse options, the remaining arguments form the command
+    long period = 1000;    // Signed, "-n -5" must not wrap past the minimum
+    bool diff = false;
+    size_t i = 1;
+    for (; i < args.size(); i++) {
+        if (args[i] == "-n" && i + 1 < args.size()) {
+            period = args[++i].toInt();
+        } else if (args[i] == "-d") {
+            diff = true;
+        } else {
+            break;
+        }
+    }
+    if (i >= args.size() || period < 100) {
+        cliPrintln("Usage: watch -n <ms> [-d] <command...> (period >= 100 ms)");
+        return;
+    }
+
+    Command* cmd = m_cli.findCommand(args[i]);
+    if (cmd == nullptr || cmd->command.equalsIgnoreCase("watch")) {
+        cliPrint("Unknown command: ");
+        cliPrintln(args[i]);
+        return;
+    }
+
+    stopWatch();
+    _watchCallback = cmd->callback;
+    _watchArgs.assign(args.begin() + i, args.end());
+    _watchDiff = diff;
+    _watchJson = m_cli.isJsonOutput();
+    _watchPeriod = period;
+    _watchSink = m_cli.getCurrentSink();
+    _watchOutput = "";
+    _watchTask = Sched.addTask(period, [this]() { runWatch(); });
+    if (_watchTask < 0) {
+        cliPrintln("No free scheduler slot");
+        return;
+    }
+    // Piped watch: the pipeline outlives this command
+    m_cli.holdOutput();
+    runWatch();
+}
+
+void CommandManager::stopWatch() {
+    if (_watchTask >= 0) {
+        Sched.removeTask(_watchTask);
+        _watchTask = -1;
+        m_cli.releaseOutput(_watchSink);
+    }
+    _watchSink = nullptr;
+    _watchArgs.clear();
+    _watchOutput = "";
+}
+
+void CommandManager::runWatch() {
+    if (m_cli.isOutputClosed(_watchSink)) {
+        stopWatch();   // e.g. "| head 10" has its records
+        return;
+    }
+
+    // Answer the session that started the watch, in the format it asked for
+    OutputSink* prev = m_cli.redirect(_watchSink);
+    bool prevJson = m_cli.setJsonOnce(_watchJson);
+    if (!_watchDiff) {
+        _watchCallback(_watchArgs);
+        m_cli.setJsonOnce(prevJson);
+        m_cli.redirect(prev);
+        return;
+    }
+
+    // Capture the output and only print lines that differ from the last run
+    String output;
+    StringSink capture(output);
+    capture.format = _watchSink != nullptr ? _watchSink->format : OutputFormat::text;
+    m_cli.redirect(&capture);
+    _watchCallback(_watchArgs);
+    m_cli.redirect(_watchSink);
+
+    int pos = 0;
+    int lastPos = 0;
+    while (pos < (int)output.length()) {
+        int end = output.indexOf('\n', pos);
+        if (end < 0) {
+            end = output.length() - 1;
+        }
+        int lastEnd = _watchOutput.indexOf('\n', lastPos);
+        bool same = lastEnd >= 0 && (end - pos) == (lastEnd - lastPos) &&
+                    strncmp(output.c_str() + pos, _watchOutput.c_str() + lastPos, end - pos) == 0;
+        if (!same) {
+            cliPrint(output.substring(pos, end + 1));
+        }
+        pos = end + 1;
+        lastPos = lastEnd >= 0 ? lastEnd + 1 : _watchOutput.length();
+    }
+    _watchOutput = output;
+    m_cli.setJsonOnce(prevJson);
+    m_cli.redirect(prev);
+}
+
+#endif // CLI_GROUP_DEBUG
@@ -0,0 +1,133 @@
+#include "cli_command.h"
+
+#if CLI_GROUP_NETWORK
+
+#include <esp_wifi.h>
+#include <wifi_store.h>
+
+void CommandManager::registerNetworkCommands() {
+    // WiFi command
+    registerCommand(CommandAdvanced(
+        "wifi",
+        "WiFi operations and information",
+        [this](const std::vector<String>& args) { cmdWifi(args); },
+        "wifi <status|scan|connect|disconnect|save [static]|forget>",
+        CommandGroup::NETWORK,
+        2, 4
+    ));
+}
+
+void CommandManager::cmdWifi(const std::vector<String>& args) {
+    if (args.size() < 2) {
+        cliPrintln("Usage: wifi <status|scan|connect|disconnect|save [static]|forget>");
+        return;
+    }
+    
+    if (args[1].equalsIgnoreCase("status") && m_cli.isJsonOutput()) {
+        SystemSnapshot state;
+        State.read(state);
+        JsonWriter json(jsonBuffer(), CMD_JSON_BUFFER_SIZE);
+        json.beginObject();
+        addWifiJson(json, state);
+        json.endObject();
+        cliWriteJson(json);
+    } else if (args[1].equalsIgnoreCase("status")) {
+        SystemSnapshot state;
+        State.read(state);
+        cliPrintln("WiFi Status:");
+        if (state.connected) {
+            cliPrintln("- Status: Connected");
+            cliPrint("- SSID: ");
+            cliPrintln(state.ssid);
+            cliPrint("- IP address: ");
+            cliPrintln(IPAddress(state.ip).toString());
+            cliPrint("- Signal strength: ");
+            cliPrint(String(state.rssi));
+            cliPrintln(" dBm");
+            cliPrint("- Channel: ");
+            cliPrintln(String(state.channel));
+        } else {
+            cliPrintln("- Status: Disconnected");
+        }
+        cliPrint("- Last connect: ");
+        cliPrint(String(WifiConfig.getConnectTime()));
+        cliPrintln(WifiConfig.wasFastConnect() ? " ms (fast)" : " ms");
+        cliPrint("- Saved network: ");
+        if (WifiConfig.hasCredentials()) {
+            cliPrint(WifiConfig.getSSID());
+            if (WifiConfig.getChannel()) {
+                cliPrint(" (channel ");
+                cliPrint(String(WifiConfig.getChannel()));
+                cliPrint(")");
+            }
+            cliPrintln(WifiConfig.hasStaticIp() ? " static IP" : " DHCP");
+        } else {
+            cliPrintln("none");
+        }
+    } else if (args[1].equalsIgnoreCase("scan")) {
+        cliPrintln("Scanning for WiFi networks...");
+        int networks = WiFi.scanNetworks();
+        
+        if (networks == 0) {
+            cliPrintln("No networks found");
+        } else {
+            cliPrint(String(networks));
+            cliPrintln(" networks found:");
+            
+            for (int i = 0; i < networks; i++) {
+                cliPrint(String(i + 1));
+                cliPrint(": ");
+                cliPrint(WiFi.SSID(i));
+                cliPrint(" (");
+                cliPrint(String(WiFi.RSSI(i)));
+                cliPrint(" dBm) ");
+                cliPrintln((WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? "Open" : "Encrypted");
+                delay(10);
+            }
+        }
+        
+        WiFi.scanDelete();
+    } else if (args[1].equalsIgnoreCase("connect") && args.size() >= 4) {
+        cliPrint("Connecting to: ");
+        cliPrintln(args[2]);
+        
+        WiFi.begin(args[2].c_str(), args[3].c_str());
+        
+        int attempts = 0;
+        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
+            delay(500);
+            cliPrint(".");
+            attempts++;
+        }
+        cliPrintln("");
+        
+        if (WiFi.status() == WL_CONNECTED) {
+            cliPrintln("Connected successfully!");
+            cliPrint("IP address: ");
+            cliPrintln(WiFi.localIP().toString());
+        } else {
+            cliPrintln("Failed to connect");
+        }
+    } else if (args[1].equalsIgnoreCase("disconnect")) {
+        WiFi.disconnect();
+        cliPrintln("WiFi disconnected");
+    } else if (args[1].equalsIgnoreCase("save")) {
+        bool staticIp = args.size() > 2 && args[2].equalsIgnoreCase("static");
+        if (WiFi.status() != WL_CONNECTED) {
+            cliPrintln("Not connected, nothing to save");
+        } else if (WifiConfig.save(staticIp)) {
+            cliPrint("Saved ");
+            cliPrint(WifiConfig.getSSID());
+            cliPrintln(staticIp ? " with static IP" : "");
+        } else {
+            cliPrintln("Error: cannot open NVS storage, configuration not saved");
+        }
+    } else if (args[1].equalsIgnoreCase("forget")) {
+        WifiConfig.forget();
+        cliPrintln("Saved WiFi configuration erased");
+    } else {
+        cliPrintln("Unknown WiFi command");
+    }
+}
+
+#endif // CLI_GROUP_NETWORK
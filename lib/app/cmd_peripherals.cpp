@@ -0,0 +1,438 @@
+#include "cli_command.h"
+
+#if CLI_GROUP_PERIPHERALS
+
+#include <fast_gpio.h>
+#include <scheduler.h>
+#include <sensor_logger.h>
+
+void CommandManager::registerPeripheralsCommands() {
+    // GPIO command
+    registerCommand(CommandAdvanced(
+        "gpio",
+        "Control GPIO pins",
+        [this](const std::vector<String>& args) { cmdGPIO(args); },
+        "gpio <pin> <read|set|clear|toggle> | gpio <mask|wave|bench|watch> ...",
+        CommandGroup::PERIPHERALS,
+        3, 4 + FAST_GPIO_WAVE_MAX_STEPS,
+        true
+    ));
+
+    //Read sensor data
+    registerCommand(CommandAdvanced(
+        "read",
+        "Read sensor data",
+        [this](const std::vector<String>& args) {cmdReadSensor(args);},
+        "read adc [stream [ms]|stop]",
+        CommandGroup::PERIPHERALS,
+        2, 4,
+        true
+    ));
+
+    // Sensor logger channels
+    registerCommand(CommandAdvanced(
+        "sensor",
+        "Configure windowed sensor logging",
+        [this](const std::vector<String>& args) { cmdSensor(args); },
+        "sensor [add <name> <pin> [sample_ms] [window_ms] | remove <name> | <name> <rate|window> <ms> | <name> <on|off>]",
+        CommandGroup::PERIPHERALS,
+        1, 6,
+        true
+    ));
+}
+
+void CommandManager::cmdGPIO(const std::vector<String>& args) {
+    if (args.size() < 3) {
+        cliPrintln("Usage: gpio <pin> <read|set|clear|toggle>");
+        cliPrintln("       gpio mask <set|clear|toggle|read|write> <hexmask> [hexvalue]");
+        cliPrintln("       gpio wave <hexmask> <rate_hz> <step...> | gpio wave <stop|status>");
+        cliPrintln("       gpio bench <pin> [toggles]");
+        cliPrintln("       gpio watch <pin> [rising|falling|both] | gpio watch <show|stop>");
+        return;
+    }
+
+    if (args[1].equalsIgnoreCase("mask")) {
+        gpioMask(args);
+        return;
+    }
+    if (args[1].equalsIgnoreCase("wave")) {
+        gpioWave(args);
+        return;
+    }
+    if (args[1].equalsIgnoreCase("bench")) {
+        gpioBench(args);
+        return;
+    }
+    if (args[1].equalsIgnoreCase("watch")) {
+        gpioWatch(args);
+        return;
+    }
+
+    int pin = args[1].toInt();
+    if (pin < 0 || pin > 39) {
+        cliPrintln("Invalid pin number. Use 0-39");
+        return;
+    }
+    
+    if (args[2].equalsIgnoreCase("read")) {
+        cliPrint("GPIO ");
+        cliPrint(String(pin));
+        cliPrint(" value: ");
+        GPIOFast.ensureMode(pin, INPUT);
+        cliPrintln(String(digitalRead(pin)));
+    } else if (args[2].equalsIgnoreCase("set")) {
+        cliPrint("Setting GPIO ");
+        cliPrint(String(pin));
+        cliPrintln(" HIGH");
+        GPIOFast.ensureMode(pin, OUTPUT);
+        GPIOFast.setMask(1ULL << pin);
+    } else if (args[2].equalsIgnoreCase("clear")) {
+        cliPrint("Setting GPIO ");
+        cliPrint(String(pin));
+        cliPrintln(" LOW");
+        GPIOFast.ensureMode(pin, OUTPUT);
+        GPIOFast.clearMask(1ULL << pin);
+    } else if (args[2].equalsIgnoreCase("toggle")) {
+        cliPrint("Toggling GPIO ");
+        cliPrintln(String(pin));
+        GPIOFast.ensureMode(pin, OUTPUT);
+        GPIOFast.toggleMask(1ULL << pin);
+    } else {
+        cliPrintln("Unknown GPIO operation. Use read, set, clear, or toggle");
+    }
+}
+
+// Format a pin mask as 0x followed by 10 hex digits (GPIO 0-39)
+static String formatMask(uint64_t mask) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "0x%02X%08X", (unsigned)(mask >> 32), (unsigned)(uint32_t)mask);
+    return String(buf);
+}
+
+void CommandManager::gpioMask(const std::vector<String>& args) {
+    if (args.size() < 4) {
+        cliPrintln("Usage: gpio mask <set|clear|toggle|read|write> <hexmask> [hexvalue]");
+        return;
+    }
+    uint64_t mask = strtoull(args[3].c_str(), nullptr, 16);
+
+    if (args[2].equalsIgnoreCase("read")) {
+        cliPrint("GPIO levels: ");
+        cliPrintln(formatMask(GPIOFast.readAll() & mask));
+        return;
+    }
+
+    if (!GPIOFast.ensureOutput(mask)) {
+        cliPrintln("Invalid mask. Output pins are 0-5, 12-33");
+        return;
+    }
+
+    if (args[2].equalsIgnoreCase("set")) {
+        GPIOFast.setMask(mask);
+    } else if (args[2].equalsIgnoreCase("clear")) {
+        GPIOFast.clearMask(mask);
+    } else if (args[2].equalsIgnoreCase("toggle")) {
+        GPIOFast.toggleMask(mask);
+    } else if (args[2].equalsIgnoreCase("write") && args.size() >= 5) {
+        GPIOFast.writeMask(mask, strtoull(args[4].c_str(), nullptr, 16));
+    } else {
+        cliPrintln("Unknown mask operation. Use set, clear, toggle, read, or write");
+        return;
+    }
+    cliPrint("GPIO mask ");
+    cliPrint(formatMask(mask));
+    cliPrintln(" updated");
+}
+
+void CommandManager::gpioWave(const std::vector<String>& args) {
+    if (args[2].equalsIgnoreCase("stop") || args[2].equalsIgnoreCase("status")) {
+        if (args[2].equalsIgnoreCase("stop")) {
+            GPIOFast.stopWave();
+        }
+        cliPrint("Wave: ");
+        cliPrintln(GPIOFast.isWaveRunning() ? "running" : "stopped");
+        cliPrint("- Requested rate: ");
+        cliPrint(String(GPIOFast.getWaveRate()));
+        cliPrintln(" Hz");
+        cliPrint("- Measured rate: ");
+        cliPrint(String(GPIOFast.getWaveMeasuredRate(), 1));
+        cliPrintln(" Hz");
+        cliPrint("- Steps played: ");
+        cliPrintln(String(GPIOFast.getWaveSteps()));
+        return;
+    }
+
+    if (args.size() < 5) {
+        cliPrintln("Usage: gpio wave <hexmask> <rate_hz> <step...>");
+        return;
+    }
+    uint64_t mask = strtoull(args[2].c_str(), nullptr, 16);
+    uint32_t rate = args[3].toInt();
+
+    uint64_t steps[FAST_GPIO_WAVE_MAX_STEPS];
+    size_t count = 0;
+    for (size_t i = 4; i < args.size() && count < FAST_GPIO_WAVE_MAX_STEPS; i++) {
+        steps[count++] = strtoull(args[i].c_str(), nullptr, 16);
+    }
+
+    if (!GPIOFast.startWave(mask, steps, count, rate)) {
+        cliPrint("Failed to start wave (rate 1-");
+        cliPrint(String(FAST_GPIO_WAVE_MAX_RATE));
+        cliPrintln(" Hz, output pins only)");
+        return;
+    }
+    cliPrint("Playing ");
+    cliPrint(String((unsigned)count));
+    cliPrint(" steps at ");
+    cliPrint(String(rate));
+    cliPrintln(" Hz");
+}
+
+void CommandManager::gpioBench(const std::vector<String>& args) {
+    int pin = args[2].toInt();
+    if (pin < 0 || pin > 39 || !(FAST_GPIO_OUTPUT_MASK & (1ULL << pin))) {
+        cliPrintln("Invalid pin number. Output pins are 0-5, 12-33");
+        return;
+    }
+    long toggles = args.size() > 3 ? args[3].toInt() : 100000;
+    if (toggles <= 0) {
+        cliPrint("Invalid toggle count. Use 1-");
+        cliPrintln(String(FAST_GPIO_BENCH_MAX_TOGGLES));
+        return;
+    }
+    // The cycle counter wraps after 2^32 cycles (~17.9 s at 240 MHz)
+    if (toggles > (long)FAST_GPIO_BENCH_MAX_TOGGLES) {
+        toggles = FAST_GPIO_BENCH_MAX_TOGGLES;
+    }
+    if (toggles < 2) {
+        toggles = 2;
+    }
+
+    uint32_t cpuHz = ESP.getCpuFreqMHz() * 1000000UL;
+    uint32_t regCycles = GPIOFast.benchRegister(pin, toggles);
+    uint32_t dwCycles = GPIOFast.benchDigitalWrite(pin, toggles);
+
+    cliPrint("Register toggles: ");
+    cliPrint(String((float)toggles * cpuHz / regCycles / 1000.0f, 1));
+    cliPrintln(" kHz");
+    cliPrint("digitalWrite toggles: ");
+    cliPrint(String((float)toggles * cpuHz / dwCycles / 1000.0f, 1));
+    cliPrintln(" kHz");
+}
+
+// Print "<label>min/max/mean" of a cycle statistic in microseconds
+void CommandManager::printEdgeStat(const char* label, const EdgeStat& stat) {
+    cliPrint(label);
+    if (stat.count == 0) {
+        cliPrintln("-");
+        return;
+    }
+    float cyclesPerUs = ESP.getCpuFreqMHz();
+    cliPrint(String(stat.min / cyclesPerUs, 2));
+    cliPrint(" / ");
+    cliPrint(String(stat.max / cyclesPerUs, 2));
+    cliPrint(" / ");
+    cliPrint(String((float)stat.sum / stat.count / cyclesPerUs, 2));
+    cliPrintln(" us (min/max/mean)");
+}
+
+void CommandManager::gpioWatch(const std::vector<String>& args) {
+    if (args[2].equalsIgnoreCase("stop")) {
+        EdgeWatch.stop();
+        cliPrintln("GPIO watch stopped");
+    } else if (!args[2].equalsIgnoreCase("show")) {
+        int pin = args[2].toInt();
+        int mode = CHANGE;
+        if (args.size() > 3) {
+            if (args[3].equalsIgnoreCase("rising")) {
+                mode = RISING;
+            } else if (args[3].equalsIgnoreCase("falling")) {
+                mode = FALLING;
+            } else if (!args[3].equalsIgnoreCase("both")) {
+                cliPrintln("Invalid edge. Use rising, falling, or both");
+                return;
+            }
+        }
+        if (pin < 0 || !EdgeWatch.start(pin, mode)) {
+            cliPrintln("Invalid pin number. Use 0-39");
+            return;
+        }
+        // The pin is now an input, whatever mode the cache held
+        GPIOFast.invalidateMode(pin);
+        cliPrint("Watching GPIO ");
+        cliPrintln(String(pin));
+        return;
+    }
+
+    // show / stop: summarize everything captured so far
+    EdgeWatch.drain();
+    cliPrint("GPIO ");
+    cliPrint(String(EdgeWatch.getPin()));
+    cliPrint(" watch: ");
+    cliPrintln(EdgeWatch.isActive() ? "active" : "stopped");
+    cliPrint("- Rising edges: ");
+    cliPrintln(String(EdgeWatch.getRising()));
+    cliPrint("- Falling edges: ");
+    cliPrintln(String(EdgeWatch.getFalling()));
+    cliPrint("- Overflows: ");
+    cliPrintln(String(EdgeWatch.getOverflows()));
+
+    const EdgeStat& period = EdgeWatch.getPeriod();
+    cliPrint("- Frequency: ");
+    if (period.count > 0) {
+        float meanUs = (float)period.sum / period.count / ESP.getCpuFreqMHz();
+        cliPrint(String(1000000.0f / meanUs, 2));
+        cliPrintln(" Hz");
+    } else {
+        cliPrintln("-");
+    }
+    printEdgeStat("- Period: ", period);
+    printEdgeStat("- High width: ", EdgeWatch.getHighWidth());
+    printEdgeStat("- Low width: ", EdgeWatch.getLowWidth());
+}
+
+void CommandManager::cmdReadSensor(const std::vector<String>& args) {
+    if (args.size() < 2 || !args[1].equalsIgnoreCase("adc")) {
+        cliPrintln("Usage: read adc [stream [ms]|stop]");
+        return;
+    }
+    if (args.size() > 2 && args[2].equalsIgnoreCase("stop")) {
+        stopStream();
+        cliPrintln("Stream stopped");
+        return;
+    }
+    if (args.size() > 2 && args[2].equalsIgnoreCase("stream")) {
+        long period = args.size() > 3 ? args[3].toInt() : 10;   // Signed, "-5" must not wrap
+        if (period < 1) {
+            cliPrintln("Period must be at least 1 ms");
+            return;
+        }
+        stopStream();
+        _streamSink = m_cli.getCurrentSink();
+        _streamTask = Sched.addTask(period, [this]() { runStream(); });
+        if (_streamTask < 0) {
+            cliPrintln("No free scheduler slot");
+            return;
+        }
+        // Piped stream: the pipeline outlives this command
+        m_cli.holdOutput();
+        return;
+    }
+
+    int value = analogRead(A0);
+    cliPrint("ADC value: ");
+    cliPrintln(String(value));
+}
+
+void CommandManager::stopStream() {
+    if (_streamTask >= 0) {
+        Sched.removeTask(_streamTask);
+        _streamTask = -1;
+        m_cli.releaseOutput(_streamSink);
+    }
+    _streamSink = nullptr;
+}
+
+void CommandManager::runStream() {
+    if (m_cli.isOutputClosed(_streamSink)) {
+        stopStream();
+        return;
+    }
+    // One bare record per sample, for the pipeline stages
+    char line[12];
+    int len = snprintf(line, sizeof(line), "%d\r\n", analogRead(A0));
+    OutputSink* prev = m_cli.redirect(_streamSink);
+    m_cli.write(line, len);
+    m_cli.redirect(prev);
+}
+
+void CommandManager::cmdSensor(const std::vector<String>& args) {
+    if (args.size() == 1) {
+        char line[128];
+        bool any = false;
+        for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+            SensorChannel* ch = Sensors.channel(i);
+            if (ch == nullptr) {
+                continue;
+            }
+            any = true;
+            snprintf(line, sizeof(line), "%-10s pin %-2u every %u ms, window %u ms, %s",
+                     ch->name, ch->pin, (unsigned)ch->sampleMs, (unsigned)ch->windowMs,
+                     ch->enabled ? "on" : "off");
+            cliPrintln(line);
+            if (ch->hasLast) {
+                const WindowStats& w = ch->last;
+                snprintf(line, sizeof(line), "  n=%u min=%.0f max=%.0f mean=%.1f sd=%.1f p50=%.0f p90=%.0f p99=%.0f",
+                         (unsigned)w.count, w.min, w.max, w.mean, w.stddev, w.p50, w.p90, w.p99);
+                cliPrintln(line);
+            }
+        }
+        if (!any) {
+            cliPrintln("No sensor channels");
+        }
+        return;
+    }
+
+    if (args[1].equalsIgnoreCase("add")) {
+        if (args.size() < 4) {
+            cliPrintln("Usage: sensor add <name> <pin> [sample_ms] [window_ms]");
+            return;
+        }
+        // Signed, "-1" must not wrap into a window of 49 days
+        long pin = args[3].toInt();
+        long sampleMs = args.size() > 4 ? args[4].toInt() : SENSOR_DEFAULT_SAMPLE_MS;
+        long windowMs = args.size() > 5 ? args[5].toInt() : SENSOR_DEFAULT_WINDOW_MS;
+        if (pin < 0 || pin > 255 || digitalPinToAnalogChannel(pin) < 0) {
+            cliPrintln("Not an analog input pin");
+            return;
+        }
+        if (sampleMs < 1 || windowMs < sampleMs) {
+            cliPrintln("Sample period must be >= 1 ms and no longer than the window");
+            return;
+        }
+        if (Sensors.addChannel(args[2].c_str(), pin, sampleMs, windowMs) == nullptr) {
+            cliPrintln("Cannot add channel (name taken, or no free channel or scheduler slot)");
+            return;
+        }
+        cliPrintln("Channel added");
+        return;
+    }
+
+    if (args[1].equalsIgnoreCase("remove")) {
+        SensorChannel* ch = args.size() > 2 ? Sensors.find(args[2]) : nullptr;
+        if (ch == nullptr || !Sensors.removeChannel(ch)) {
+            cliPrintln("Unknown channel");
+            return;
+        }
+        cliPrintln("Channel removed");
+        return;
+    }
+
+    SensorChannel* ch = Sensors.find(args[1]);
+    if (ch == nullptr) {
+        cliPrintln("Unknown channel");
+        return;
+    }
+    if (args.size() < 3) {
+        cliPrintln(CMD_MSG_INVALID_ARGS);
+        return;
+    }
+    if (args[2].equalsIgnoreCase("on") || args[2].equalsIgnoreCase("off")) {
+        if (!Sensors.setEnabled(ch, args[2].equalsIgnoreCase("on"))) {
+            cliPrintln("No free scheduler slot");
+        }
+        return;
+    }
+    long ms = args.size() > 3 ? args[3].toInt() : 0;   // Signed, see 'sensor add'
+    if (args[2].equalsIgnoreCase("rate") && ms >= 1 && ms <= (long)ch->windowMs) {
+        if (!Sensors.setSampleRate(ch, ms)) {
+            cliPrintln("Error: sampling task not found, rate not applied");
+        }
+    } else if (args[2].equalsIgnoreCase("window") && ms >= 1 && ms >= (long)ch->sampleMs) {
+        Sensors.setWindow(ch, ms);
+    } else {
+        cliPrintln("Usage: sensor <name> rate <ms> | sensor <name> window <ms> (rate <= window)");
+    }
+}
+
+#endif // CLI_GROUP_PERIPHERALS
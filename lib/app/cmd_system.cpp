@@ -0,0 +1,443 @@
+#include "cli_command.h"
+
+#if CLI_GROUP_SYSTEM
+
+#include <esp_heap_caps.h>
+#include <heap_map.h>
+#include <LittleFS.h>
+#include <ymodem.h>
+
+void CommandManager::registerSystemCommands() {
+    //Status command
+    registerCommand(CommandAdvanced(
+        "status", 
+        "Show system status",
+         [this](const std::vector<String>& args) {cmdStatus(args);},
+         "status",
+         CommandGroup::SYSTEM,
+         1,1
+    ));
+
+    //Info command
+    registerCommand(CommandAdvanced(
+        "info", 
+        "Show system information",
+         [this](const std::vector<String>& args) {cmdInfo(args);},
+         "info [detail]",
+         CommandGroup::SYSTEM,
+         1,22
+    ));
+
+    // State command
+    registerCommand(CommandAdvanced(
+        "state",
+        "Show how old the cached system state is",
+        [this](const std::vector<String>& args) { cmdState(args); },
+        "state",
+        CommandGroup::SYSTEM,
+        1, 1
+    ));
+
+    // Restart command
+    registerCommand(CommandAdvanced(
+        "restart",
+        "Restart the ESP32",
+        [this](const std::vector<String>& args) { cmdRestart(args); },
+        "restart",
+        CommandGroup::SYSTEM,
+        1, 1
+    ));
+
+    // Memory command
+    registerCommand(CommandAdvanced(
+        "memory",
+        "Show memory usage",
+        [this](const std::vector<String>& args) { cmdMemory(args); },
+        "memory [map [blocks]|trace [reset]]",
+        CommandGroup::SYSTEM,
+        1, 3,
+        true
+    ));
+
+    // File transfer commands
+    registerCommand(CommandAdvanced(
+        "put",
+        "Receive a file into LittleFS (YMODEM)",
+        [this](const std::vector<String>& args) { cmdTransfer(args); },
+        "put <path>",
+        CommandGroup::SYSTEM,
+        2, 2
+    ));
+    registerCommand(CommandAdvanced(
+        "get",
+        "Send a file from LittleFS (YMODEM)",
+        [this](const std::vector<String>& args) { cmdTransfer(args); },
+        "get <path>",
+        CommandGroup::SYSTEM,
+        2, 2
+    ));
+}
+
+void CommandManager::cmdStatus(const std::vector<String>& args) {
+    if (m_cli.isJsonOutput()) {
+        statusJson();
+        return;
+    }
+
+    SystemSnapshot state;
+    State.read(state);
+
+    cliPrintln("--- System Status ---");
+    // WiFi status
+    cliPrint("WiFi: ");
+    cliPrint(state.connected ? "Connected to " : "Disconnected");
+    if (state.connected) {
+      cliPrintln(state.ssid);
+      cliPrint("IP: ");
+      cliPrintln(IPAddress(state.ip).toString());
+      cliPrint("Signal: ");
+      cliPrint(String(state.rssi));
+      cliPrintln(" dBm");
+    } else {
+      cliPrintln("");
+    }
+    
+    // Time
+    cliPrint("Current time: ");
+    cliPrintln(state.timestamp);
+    
+    // Memory
+    cliPrint("Free heap: ");
+    cliPrint(String(state.heapFree));
+    cliPrintln(" bytes");
+    
+    // Telnet status
+    //TODO: check if TelnetStream is connected
+    // cliPrint("Telnet client: ");
+    // cliPrintln(CLI.isClientConnected() ? "Connected" : "Not connected");
+    
+    // Current interface
+    cliPrint("Current interface: ");
+    cliPrintln(interfaceName(m_cli.getCurrentInterface()));
+}
+
+void CommandManager::statusJson() {
+    JsonWriter json(jsonBuffer(), CMD_JSON_BUFFER_SIZE);
+    SystemSnapshot state;
+    State.read(state);
+
+    json.beginObject();
+    addWifiJson(json, state);
+    json.add("time", state.timestamp);
+    json.add("heap_free", state.heapFree);
+    json.add("interface", interfaceName(m_cli.getCurrentInterface()));
+    json.endObject();
+    cliWriteJson(json);
+}
+
+void CommandManager::cmdState(const std::vector<String>& args) {
+    SystemSnapshot state;
+    State.read(state);
+
+    if (m_cli.isJsonOutput()) {
+        JsonWriter json(jsonBuffer(), CMD_JSON_BUFFER_SIZE);
+        json.beginObject();
+        json.beginObject("age_ms");
+        for (uint8_t i = 0; i < static_cast<uint8_t>(StateField::COUNT); i++) {
+            // -1 when never updated
+            uint32_t age = SystemState::age(state, static_cast<StateField>(i));
+            json.add(SystemState::fieldName(static_cast<StateField>(i)), age == UINT32_MAX ? -1L : (long)age);
+        }
+        json.endObject();
+        json.endObject();
+        cliWriteJson(json);
+        return;
+    }
+
+    cliPrintln("System state (age of each field):");
+    char line[48];
+    for (uint8_t i = 0; i < static_cast<uint8_t>(StateField::COUNT); i++) {
+        uint32_t age = SystemState::age(state, static_cast<StateField>(i));
+        if (age == UINT32_MAX) {
+            snprintf(line, sizeof(line), "- %-5s never updated", SystemState::fieldName(static_cast<StateField>(i)));
+        } else {
+            snprintf(line, sizeof(line), "- %-5s %lu ms", SystemState::fieldName(static_cast<StateField>(i)), (unsigned long)age);
+        }
+        cliPrintln(line);
+    }
+}
+
+void CommandManager::cmdInfo(const std::vector<String>& args) {
+    // Everything but the CPU frequency is fixed after boot and rendered
+    // once. The frequency follows setCpuFrequencyMhz() and, with light
+    // sleep, dynamic frequency scaling, so it is read on every call.
+    bool detail = args.size() > 1 && args[1].equalsIgnoreCase("detail");
+    if (m_cli.isJsonOutput()) {
+        const String& cached = renderCached(detail ? CachedResponse::INFO_DETAIL_JSON : CachedResponse::INFO_JSON,
+                                            [this, detail]() { infoJson(detail); });
+        // Live member spliced in front of the cached ones: {"cpu_mhz":N,...
+        char head[24];
+        int len = snprintf(head, sizeof(head), "{\"cpu_mhz\":%u,", (unsigned)ESP.getCpuFreqMHz());
+        m_cli.write(head, len);
+        m_cli.write(cached.c_str() + 1, cached.length() - 1);
+    } else {
+        writeCached(CachedResponse::INFO, [this]() { infoText(); });
+        cliPrint("- CPU frequency: ");
+        cliPrint(String(ESP.getCpuFreqMHz()));
+        cliPrintln(" MHz");
+        if (detail) {
+            writeCached(CachedResponse::INFO_DETAIL, [this]() { infoDetailText(); });
+        }
+    }
+}
+
+void CommandManager::infoText() {
+    cliPrintln("ESP32 System Information:");
+    cliPrint("- Chip model: ");
+    cliPrintln(ESP.getChipModel());
+    cliPrint("- Chip cores: ");
+    cliPrintln(String(ESP.getChipCores()));
+    cliPrint("- Flash size: ");
+    cliPrint(String(ESP.getFlashChipSize() / 1024 / 1024));
+    cliPrintln(" MB");
+    cliPrint("- SDK version: ");
+    cliPrintln(ESP.getSdkVersion());
+}
+
+void CommandManager::infoDetailText() {
+    cliPrintln("\nDetailed Information:");
+    cliPrint("- Heap size: ");
+    cliPrint(String(ESP.getHeapSize() / 1024));
+    cliPrintln(" KB");
+    cliPrint("- MAC address: ");
+    cliPrintln(WiFi.macAddress());
+    cliPrint("- Sketch size: ");
+    cliPrint(String(ESP.getSketchSize() / 1024));
+    cliPrintln(" KB");
+    cliPrint("- Free sketch space: ");
+    cliPrint(String(ESP.getFreeSketchSpace() / 1024));
+    cliPrintln(" KB");
+}
+
+void CommandManager::infoJson(bool detail) {
+    JsonWriter json(jsonBuffer(), CMD_JSON_BUFFER_SIZE);
+
+    json.beginObject();
+    json.add("chip", ESP.getChipModel());
+    json.add("cores", (unsigned)ESP.getChipCores());
+    json.add("flash_mb", ESP.getFlashChipSize() / 1024 / 1024);
+    json.add("sdk", ESP.getSdkVersion());
+    if (detail) {
+        uint8_t mac[6];
+        char macStr[18];
+        WiFi.macAddress(mac);
+        snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        json.add("heap_kb", ESP.getHeapSize() / 1024);
+        json.add("mac", macStr);
+        json.add("sketch_kb", ESP.getSketchSize() / 1024);
+        json.add("free_sketch_kb", ESP.getFreeSketchSpace() / 1024);
+    }
+    json.endObject();
+    cliWriteJson(json);
+}
+
+void CommandManager::cmdRestart(const std::vector<String>& args) {
+    cliPrintln("Restarting ESP32...");
+    delay(500);
+    ESP.restart();
+}
+
+void CommandManager::cmdMemory(const std::vector<String>& args) {
+    if (args.size() > 1 && args[1].equalsIgnoreCase("map")) {
+        memoryMap(args);
+        return;
+    }
+    if (args.size() > 1 && args[1].equalsIgnoreCase("trace")) {
+        memoryTrace(args);
+        return;
+    }
+    if (m_cli.isJsonOutput()) {
+        JsonWriter json(jsonBuffer(), CMD_JSON_BUFFER_SIZE);
+        json.beginObject();
+        json.add("free", ESP.getFreeHeap());
+        json.add("size", ESP.getHeapSize());
+        json.add("min_free", ESP.getMinFreeHeap());
+        json.add("max_alloc", ESP.getMaxAllocHeap());
+        json.endObject();
+        cliWriteJson(json);
+        return;
+    }
+
+    cliPrintln("Memory Information:");
+    cliPrint("- Free heap: ");
+    cliPrint(String(ESP.getFreeHeap() / 1024));
+    cliPrintln(" KB");
+    cliPrint("- Heap size: ");
+    cliPrint(String(ESP.getHeapSize() / 1024));
+    cliPrintln(" KB");
+    cliPrint("- Min free heap: ");
+    cliPrint(String(ESP.getMinFreeHeap() / 1024));
+    cliPrintln(" KB");
+    cliPrint("- Max alloc heap: ");
+    cliPrint(String(ESP.getMaxAllocHeap() / 1024));
+    cliPrintln(" KB");
+}
+
+void CommandManager::memoryMap(const std::vector<String>& args) {
+    static const struct {
+        uint32_t caps;
+        const char* name;
+    } HEAP_CAPS[] = {
+        { MALLOC_CAP_8BIT, "8BIT" },
+        { MALLOC_CAP_32BIT, "32BIT" },
+        { MALLOC_CAP_DMA, "DMA" },
+        { MALLOC_CAP_INTERNAL, "INTERNAL" },
+        { MALLOC_CAP_SPIRAM, "SPIRAM" },
+    };
+    bool blocks = args.size() > 2 && args[2].equalsIgnoreCase("blocks");
+
+    cliPrintln("Heap map (free bytes / largest block / free blocks / mean block / fragmentation):");
+    for (const auto& heap : HEAP_CAPS) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, heap.caps);
+
+        char line[96];
+        if (info.total_free_bytes == 0 && info.total_allocated_bytes == 0) {
+            snprintf(line, sizeof(line), "- %-8s not present", heap.name);
+        } else {
+            unsigned meanBlock = info.free_blocks ? info.total_free_bytes / info.free_blocks : 0;
+            unsigned frag = info.total_free_bytes ? 100 - (info.largest_free_block * 100 / info.total_free_bytes) : 0;
+            snprintf(line, sizeof(line), "- %-8s %7u / %7u / %4u / %6u / %3u%%", heap.name,
+                     (unsigned)info.total_free_bytes, (unsigned)info.largest_free_block,
+                     (unsigned)info.free_blocks, meanBlock, frag);
+        }
+        cliPrintln(line);
+
+        FreeBlockHistogram hist;
+        if (blocks && HeapMaps.probe(heap.caps, hist)) {
+            for (uint8_t i = 0; i < HEAP_MAP_BUCKETS; i++) {
+                if (hist.buckets[i] == 0) {
+                    continue;
+                }
+                snprintf(line, sizeof(line), "    >= %6u B: %3u", (unsigned)HeapMap::bucketMin(i), hist.buckets[i]);
+                cliPrintln(line);
+            }
+            if (hist.rest > 0) {
+                snprintf(line, sizeof(line), "    not probed: %3u blocks, %u B%s", hist.rest, (unsigned)hist.restBytes,
+                         hist.reserveHit ? " (kept free as reserve)" : "");
+                cliPrintln(line);
+            }
+        }
+    }
+
+    // Largest block drift, a falling trend means the heap is fragmenting
+    uint8_t samples = HeapMaps.getTrendCount();
+    if (samples == 0) {
+        return;
+    }
+    cliPrint("Largest 8BIT block, one sample per ");
+    cliPrint(String(HEAP_TREND_INTERVAL_MS / 60000));
+    cliPrintln(" min, oldest first:");
+    char line[HEAP_TREND_SIZE * 11 + 1];
+    size_t len = 0;
+    for (uint8_t i = 0; i < samples; i++) {
+        len += snprintf(line + len, sizeof(line) - len, " %u", (unsigned)HeapMaps.getTrend(i));
+    }
+    cliPrintln(line);
+    int32_t change = (int32_t)HeapMaps.getTrend(samples - 1) - (int32_t)HeapMaps.getTrend(0);
+    cliPrint("Change: ");
+    cliPrint(String(change));
+    cliPrintln(" bytes");
+}
+
+void CommandManager::memoryTrace(const std::vector<String>& args) {
+    if (!AllocTrace.isEnabled()) {
+        cliPrintln("Allocation tracing not compiled in (build with -DCLI_ALLOC_TRACE)");
+        return;
+    }
+    if (args.size() > 2 && args[2].equalsIgnoreCase("reset")) {
+        AllocTrace.resetLoopStats();
+        cliPrintln("Loop allocation statistics reset");
+        return;
+    }
+
+    AllocCounters total = AllocTrace.snapshot();
+    cliPrint("Since boot: ");
+    cliPrint(String(total.allocs));
+    cliPrint(" allocations, ");
+    cliPrint(String(total.frees));
+    cliPrint(" frees, ");
+    cliPrint(String(total.bytes));
+    cliPrintln(" bytes");
+
+    cliPrint("Loop: ");
+    cliPrint(String(AllocTrace.getLoopsAllocating()));
+    cliPrint(" of ");
+    cliPrint(String(AllocTrace.getLoops()));
+    cliPrint(" iterations allocated, ");
+    cliPrint(String(AllocTrace.getLoopTotal().allocs));
+    cliPrint(" allocations, max ");
+    cliPrint(String(AllocTrace.getLoopMaxAllocs()));
+    cliPrintln(" per iteration");
+
+    cliPrintln("Per command (calls / last allocations / last bytes / total allocations):");
+    for (const auto& cmd : m_cli.getCommands()) {
+        if (cmd.calls == 0) {
+            continue;
+        }
+        char line[80];
+        snprintf(line, sizeof(line), "  %-15s %6u / %5u / %7u / %8u", cmd.command.c_str(),
+                 (unsigned)cmd.calls, (unsigned)cmd.lastAllocs.allocs,
+                 (unsigned)cmd.lastAllocs.bytes, (unsigned)cmd.allocs.allocs);
+        cliPrintln(line);
+    }
+}
+
+void CommandManager::cmdTransfer(const std::vector<String>& args) {
+    bool receive = args[0].equalsIgnoreCase("put");
+    if (args.size() < 2 || !args[1].startsWith("/")) {
+        cliPrintln(receive ? "Usage: put </path>" : "Usage: get </path>");
+        return;
+    }
+    Stream* stream = m_cli.getCurrentStream();
+    if (stream == nullptr) {
+        cliPrintln(CMD_MSG_EXEC_ERROR);
+        return;
+    }
+
+    static bool mounted = false;
+    if (!mounted && !(mounted = LittleFS.begin(true))) {
+        cliPrintln("Error: LittleFS mount failed");
+        return;
+    }
+    if (!receive && !LittleFS.exists(args[1].c_str())) {
+        cliPrint("File not found: ");
+        cliPrintln(args[1]);
+        return;
+    }
+
+    cliPrintln(receive ? "Start the YMODEM send now" : "Start the YMODEM receive now");
+    // Anything else written to the session would land inside the frames:
+    // sensor/debug broadcasts, logs, watch or stream output from loop()
+    OutputSink* sink = m_cli.getCurrentSink();
+    m_cli.muteSink(sink, true);
+    Ymodem ymodem(*stream);
+    TransferResult result = receive ? ymodem.receive(LittleFS, args[1].c_str())
+                                    : ymodem.send(LittleFS, args[1].c_str());
+    uint32_t elapsed = ymodem.getElapsed();
+    m_cli.muteSink(sink, false);
+
+    // Let the host terminal leave transfer mode before printing
+    delay(500);
+    cliPrintln("");
+    cliPrint("Transfer: ");
+    cliPrintln(Ymodem::resultName(result));
+    cliPrint("- Bytes: ");
+    cliPrintln(String(ymodem.getBytes()));
+    cliPrint("- Throughput: ");
+    cliPrint(String(elapsed ? ymodem.getBytes() * 1000.0f / elapsed / 1024.0f : 0.0f, 2));
+    cliPrintln(" KB/s");
+}
+
+#endif // CLI_GROUP_SYSTEM
@@ -1,13 +1,37 @@
 #include "cli.h"
+#include <esp_timer.h>
+#include <idle.h>
 
 ESP32_CLI CLI;  // Create global instance
 
 
 // constructor cli
 // default interface is serial
-ESP32_CLI::ESP32_CLI() {
+ESP32_CLI::ESP32_CLI()
+  : _serial("serial", Serial, true), _telnet("telnet", TelnetStream, false) {
   _interface = OutputInterface::serial;
-  _inputBuffer = "";
+  for (auto& ctx : _context) {
+    ctx.sink = nullptr;
+    ctx.jsonOnce = false;
+  }
+  _topicMask = 0;
+  _unknownCommands = 0;
+  _task = nullptr;
+  _taskCore = tskNO_AFFINITY;
+  _appQueue = nullptr;
+  _appDone = nullptr;
+  _outputLock = nullptr;
+  _droppedBroadcasts = 0;
+  _appTimeouts = 0;
+  _appDispatches = 0;
+  _appLatencyMin = UINT32_MAX;
+  _appLatencyMax = 0;
+  _appLatencySum = 0;
+  for (auto& sink : _sinks) {
+    sink = nullptr;
+  }
+  addSink(&_serial.sink);
+  addSink(&_telnet.sink);
 }
 
 
@@ -78,81 +102,275 @@ void ESP32_CLI::begin(unsigned long baudRate) {
 // }
 
 void ESP32_CLI::print(const String& text) {
+  write(text.c_str(), text.length());
+}
+
+void ESP32_CLI::println(const String& text) {
+  write(text.c_str(), text.length());
+  write("\r\n", 2);
+}
+
+void ESP32_CLI::write(const char* data, size_t length) {
+  OutputSink* sink = context().sink;
+  lockOutput();
+  if (sink != nullptr) {
+    sink->write(data, length);
+  } else {
+    writeDefault(data, length);
+  }
+  unlockOutput();
+}
+
+void ESP32_CLI::writeDefault(const char* data, size_t length) {
   if (_interface == OutputInterface::serial || _interface == OutputInterface::BOTH) {
-    Serial.print(text);
+    _serial.sink.write(data, length);
   }
   
   if (_interface == OutputInterface::telnet || _interface == OutputInterface::BOTH) {
-    TelnetStream.print(text);
+    _telnet.sink.write(data, length);
   }
 }
 
-void ESP32_CLI::println(const String& text) {
-  if (_interface == OutputInterface::serial || _interface == OutputInterface::BOTH) {
-    Serial.println(text);
+void ESP32_CLI::setFormat(OutputFormat format) {
+  OutputSink* sink = context().sink;
+  if (sink != nullptr) {
+    sink->format = format;
   }
-  
-  if (_interface == OutputInterface::telnet || _interface == OutputInterface::BOTH) {
-    TelnetStream.println(text);
+}
+
+OutputFormat ESP32_CLI::getFormat() {
+  OutputSink* sink = context().sink;
+  return sink != nullptr ? sink->format : OutputFormat::text;
+}
+
+Stream* ESP32_CLI::getCurrentStream() {
+  OutputSink* sink = context().sink;
+  if (sink == &_serial.sink) {
+    return &_serial.stream;
   }
+  if (sink == &_telnet.sink) {
+    return &_telnet.stream;
+  }
+  return nullptr;
+}
+
+void ESP32_CLI::muteSink(OutputSink* sink, bool mute) {
+  lockOutput();
+  sink->muted = mute;
+  unlockOutput();
+}
+
+bool ESP32_CLI::addSink(OutputSink* sink) {
+  for (auto& slot : _sinks) {
+    if (slot == nullptr) {
+      slot = sink;
+      updateTopicMask();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ESP32_CLI::removeSink(OutputSink* sink) {
+  for (auto& slot : _sinks) {
+    if (slot == sink) {
+      slot = nullptr;
+    }
+  }
+  for (auto& ctx : _context) {
+    if (ctx.sink == sink) {
+      ctx.sink = nullptr;
+    }
+  }
+  updateTopicMask();
+}
+
+void ESP32_CLI::subscribe(OutputSink* sink, Topic topic, bool enable) {
+  if (enable) {
+    sink->subscriptions |= TOPIC_BIT(topic);
+  } else {
+    sink->subscriptions &= ~TOPIC_BIT(topic);
+  }
+  updateTopicMask();
+}
+
+void ESP32_CLI::updateTopicMask() {
+  _topicMask = 0;
+  for (const auto sink : _sinks) {
+    if (sink != nullptr) {
+      _topicMask |= sink->subscriptions;
+    }
+  }
+}
+
+void ESP32_CLI::broadcast(Topic topic, const char* data, size_t length) {
+  if (!hasSubscribers(topic)) {
+    return;
+  }
+  // loop() must not stall behind a command writing on the CLI task
+  if (_outputLock && xSemaphoreTakeRecursive(_outputLock, 0) != pdTRUE) {
+    _droppedBroadcasts++;
+    return;
+  }
+  for (const auto sink : _sinks) {
+    if (sink != nullptr && (sink->subscriptions & TOPIC_BIT(topic))) {
+      sink->write(data, length);
+    }
+  }
+  unlockOutput();
 }
 
 void ESP32_CLI::update() {
-  // Check for telnet input
-  if (TelnetStream.available()) {
-    char c = TelnetStream.read();
-    
-    if (c == '\n' || c == '\r') {
-      if (_inputBuffer.length() > 0) {
-        processCommand(_inputBuffer);
-        _inputBuffer = "";
-      }
-    } else if (c == 8 || c == 127) { // Backspace
-      if (_inputBuffer.length() > 0) {
-        _inputBuffer.remove(_inputBuffer.length() - 1);
-        // Echo backspace
-        if (_interface == OutputInterface::telnet || _interface == OutputInterface::BOTH) {
-        //   TelnetStream.print("\b \b");
-        }
-      }
+  if (_task != nullptr) {
+    // The CLI task reads input, loop() only runs application commands
+    serviceAppQueue();
+  } else {
+    poll();
+  }
+}
+
+bool ESP32_CLI::hasPendingInput() {
+  if (_task != nullptr) {
+    return uxQueueMessagesWaiting(_appQueue) > 0;
+  }
+  return _serial.stream.available() > 0 || _telnet.stream.available() > 0;
+}
+
+void ESP32_CLI::poll() {
+  readSession(_telnet);
+  readSession(_serial);
+}
+
+bool ESP32_CLI::startTask(BaseType_t core) {
+  if (_task != nullptr) {
+    return true;
+  }
+  // Called from setup(), on the core loop() runs on
+  if (portNUM_PROCESSORS < 2 || core == xPortGetCoreID()) {
+    return false;
+  }
+  _outputLock = xSemaphoreCreateRecursiveMutex();
+  _appQueue = xQueueCreate(CLI_APP_QUEUE_LEN, sizeof(AppRequest*));
+  _appDone = xSemaphoreCreateBinary();
+  if (_outputLock == nullptr || _appQueue == nullptr || _appDone == nullptr) {
+    return false;
+  }
+  _taskCore = core;
+  if (xTaskCreatePinnedToCore(taskLoop, "cli", CLI_TASK_STACK, this, CLI_TASK_PRIORITY, &_task, core) != pdPASS) {
+    return false;
+  }
+  // Serial input now wakes the task reading it, not loop()
+  Idle.setInputTask(_task);
+  return true;
+}
+
+void ESP32_CLI::taskLoop(void* arg) {
+  ESP32_CLI* cli = static_cast<ESP32_CLI*>(arg);
+  for (;;) {
+    cli->poll();
+    // Serial input notifies the task, telnet has no event and is polled
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(Idle.getBlockLimit()));
+  }
+}
+
+void ESP32_CLI::runOnApp(Command& command, const std::vector<String>& args) {
+  AppRequest* request = new AppRequest{ &command, args, context(), esp_timer_get_time(), false, false };
+  if (xQueueSend(_appQueue, &request, pdMS_TO_TICKS(CLI_APP_TIMEOUT_MS)) != pdTRUE) {
+    delete request;
+    println("Error: application busy");
+    return;
+  }
+  Idle.wake();
+  if (xSemaphoreTake(_appDone, pdMS_TO_TICKS(CLI_APP_TIMEOUT_MS)) == pdTRUE) {
+    delete request;
+    return;
+  }
+
+  portENTER_CRITICAL(&_appLock);
+  bool done = request->done;
+  request->abandoned = !done;
+  portEXIT_CRITICAL(&_appLock);
+  if (done) {
+    // Finished just now, the signal is on its way
+    xSemaphoreTake(_appDone, portMAX_DELAY);
+    delete request;
+    return;
+  }
+
+  // loop() is stuck or busy: give up waiting, it deletes the request. A
+  // pipeline stays open for the output the command may still produce.
+  _appTimeouts++;
+  lockOutput();
+  holdOutput();
+  unlockOutput();
+  println("Error: application timeout");
+}
+
+void ESP32_CLI::serviceAppQueue() {
+  AppRequest* request;
+  while (xQueueReceive(_appQueue, &request, 0) == pdTRUE) {
+    uint32_t latency = esp_timer_get_time() - request->postedUs;
+    _appDispatches++;
+    _appLatencySum += latency;
+    if (latency < _appLatencyMin) _appLatencyMin = latency;
+    if (latency > _appLatencyMax) _appLatencyMax = latency;
+
+    portENTER_CRITICAL(&_appLock);
+    bool abandoned = request->abandoned;
+    portEXIT_CRITICAL(&_appLock);
+    if (!abandoned) {
+      Context saved = context();
+      context() = request->context;
+      dispatch(*request->command, request->args);
+      context() = saved;
+    }
+
+    portENTER_CRITICAL(&_appLock);
+    request->done = true;
+    abandoned = request->abandoned;
+    portEXIT_CRITICAL(&_appLock);
+    if (abandoned) {
+      releaseOutput(request->context.sink);
+      delete request;
     } else {
-      _inputBuffer += c;
-      // Echo character
-      if (_interface == OutputInterface::telnet || _interface == OutputInterface::BOTH) {
-        // TelnetStream.print(c);
-      }
+      xSemaphoreGive(_appDone);
     }
   }
-  
-  // Check for serial input
-  if (Serial.available()) {
-    char c = Serial.read();
+}
+
+void ESP32_CLI::readSession(Session& session) {
+  if (!session.stream.available()) {
+    return;
+  }
+  char c = session.stream.read();
     
-    if (c == '\n' || c == '\r') {
-      if (_inputBuffer.length() > 0) {
-        processCommand(_inputBuffer);
-        _inputBuffer = "";
-      }
-    } else if (c == 8 || c == 127) { // Backspace
-      if (_inputBuffer.length() > 0) {
-        _inputBuffer.remove(_inputBuffer.length() - 1);
-        // Echo backspace
-        if (_interface == OutputInterface::serial || _interface == OutputInterface::BOTH) {
-          Serial.print("\b \b");
-        }
-      }
-    } else {
-      _inputBuffer += c;
-      // Echo character
-      if (_interface == OutputInterface::serial || _interface == OutputInterface::BOTH) {
-        Serial.print(c);
+  if (c == '\n' || c == '\r') {
+    if (session.input.length() > 0) {
+      // Everything the command prints goes back to this session
+      OutputSink* prev = redirect(&session.sink);
+      processCommand(session.input);
+      redirect(prev);
+      session.input = "";
+    }
+  } else if (c == 8 || c == 127) { // Backspace
+    if (session.input.length() > 0) {
+      session.input.remove(session.input.length() - 1);
+      // Echo backspace
+      if (session.echo) {
+        session.sink.write("\b \b", 3);
       }
     }
+  } else {
+    session.input += c;
+    // Echo character
+    if (session.echo) {
+      session.sink.write(&c, 1);
+    }
   }
 }
 
-void ESP32_CLI::addCommand(const String& command, const String& description, std::function<void(const std::vector<String>&)> callback) {
-  _commands.push_back(Command(command, description, callback));
+void ESP32_CLI::addCommand(const String& command, const String& description, std::function<void(const std::vector<String>&)> callback, bool appContext) {
+  _commands.push_back(Command(command, description, callback, appContext));
 }
 
 void ESP32_CLI::listCommands() {
@@ -165,12 +383,38 @@ void ESP32_CLI::listCommands() {
   }
 }
 
+// A pipe is a '|' standing alone between spaces, so an argument such as a
+// password may still contain one
+static int findPipe(const String& line, int from) {
+  for (int i = line.indexOf('|', from); i >= 0; i = line.indexOf('|', i + 1)) {
+    bool spaceBefore = i > 0 && line[i - 1] == ' ';
+    bool spaceAfter = i + 1 >= (int)line.length() || line[i + 1] == ' ';
+    if (spaceBefore && spaceAfter) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 void ESP32_CLI::processCommand(const String& cmd) {
   println(""); // New line after command
   
+  // "command | stage | stage..." feeds the command output through a pipeline
+  int bar = findPipe(cmd, 0);
+
   // Split the command and arguments
-  std::vector<String> parts = splitString(cmd, ' ');
+  std::vector<String> parts = splitString(bar < 0 ? cmd : cmd.substring(0, bar), ' ');
   
+  // "--json" anywhere on the line switches this one command to JSON output
+  context().jsonOnce = false;
+  for (size_t i = 1; i < parts.size(); i++) {
+    if (parts[i] == "--json") {
+      parts.erase(parts.begin() + i);
+      context().jsonOnce = true;
+      break;
+    }
+  }
+
   if (parts.empty()) {
     return;
   }
@@ -178,16 +422,28 @@ void ESP32_CLI::processCommand(const String& cmd) {
   String command = parts[0];
   
   // Find and execute command
-  bool found = false;
-  for (const auto& c : _commands) {
-    if (c.command.equalsIgnoreCase(command)) {
-      c.callback(parts);
-      found = true;
-      break;
+  Command* c = findCommand(command);
+  if (c != nullptr) {
+    OutputSink* prev = nullptr;
+    if (bar >= 0) {
+      if (!beginPipe(cmd.substring(bar + 1))) {
+        print("> ");
+        return;
+      }
+      prev = redirect(_pipe.head());
     }
-  }
-  
-  if (!found) {
+    if (_task != nullptr && c->appContext) {
+      runOnApp(*c, parts);
+    } else {
+      dispatch(*c, parts);
+    }
+    if (bar >= 0) {
+      redirect(prev);
+      endPipe();
+    }
+    context().jsonOnce = false;
+  } else {
+    _unknownCommands++;
     print("Unknown command: ");
     println(command);
     println("Type 'help' for available commands");
@@ -197,6 +453,87 @@ void ESP32_CLI::processCommand(const String& cmd) {
   print("> ");
 }
 
+bool ESP32_CLI::beginPipe(const String& stages) {
+  if (_pipe.isActive()) {
+    println("Error: a stream still feeds the pipeline, stop it first");
+    return false;
+  }
+  if (context().sink == nullptr) {
+    return false;
+  }
+
+  lockOutput();
+  _pipe.begin(context().sink);
+  bool ok = true;
+  int start = 0;
+  while (ok) {
+    int bar = findPipe(stages, start);
+    String stage = bar < 0 ? stages.substring(start) : stages.substring(start, bar);
+    ok = _pipe.addStage(splitString(stage, ' '));
+    if (!ok) {
+      print("Error: invalid pipe stage: ");
+      println(stage);
+      println(Pipeline::usage());
+    }
+    if (bar < 0) {
+      break;
+    }
+    start = bar + 1;
+  }
+  if (!ok) {
+    _pipe.end();
+  }
+  unlockOutput();
+  return ok;
+}
+
+void ESP32_CLI::endPipe() {
+  // A streaming source took over the pipeline, it releases it when done
+  lockOutput();
+  if (!_pipe.isHeld()) {
+    _pipe.end();
+  }
+  unlockOutput();
+}
+
+void ESP32_CLI::holdOutput() {
+  if (_pipe.isActive() && context().sink == _pipe.head()) {
+    _pipe.hold();
+  }
+}
+
+void ESP32_CLI::releaseOutput(OutputSink* sink) {
+  lockOutput();
+  if (_pipe.isActive() && sink == _pipe.head()) {
+    _pipe.end();
+  }
+  unlockOutput();
+}
+
+bool ESP32_CLI::isOutputClosed(OutputSink* sink) {
+  return _pipe.isActive() && sink == _pipe.head() && _pipe.isClosed();
+}
+
+void ESP32_CLI::dispatch(Command& c, const std::vector<String>& args) {
+  AllocCounters before = AllocTrace.snapshot();
+  c.callback(args);
+  AllocCounters delta = AllocTrace.snapshot() - before;
+  c.calls++;
+  c.lastAllocs = delta;
+  c.allocs.allocs += delta.allocs;
+  c.allocs.frees += delta.frees;
+  c.allocs.bytes += delta.bytes;
+}
+
+Command* ESP32_CLI::findCommand(const String& command) {
+  for (auto& c : _commands) {
+    if (c.command.equalsIgnoreCase(command)) {
+      return &c;
+    }
+  }
+  return nullptr;
+}
+
 std::vector<String> ESP32_CLI::splitString(const String& input, char delimiter) {
   std::vector<String> result;
   int start = 0;
@@ -6,6 +6,13 @@
 #include <vector>
 #include <functional>
 #include <string>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <alloc_trace.h>
+#include "output_sink.h"
+#include "pipeline.h"
 
 enum class OutputInterface {
   serial,
@@ -13,14 +20,38 @@ enum class OutputInterface {
   BOTH
 };
 
+#define CLI_MAX_SINKS 4
+#define CLI_TASK_STACK 8192
+#define CLI_TASK_PRIORITY 1
+#define CLI_APP_QUEUE_LEN 4
+#define CLI_APP_TIMEOUT_MS 30000  // Longest the CLI task waits for an app context command
+
+// An input stream with its own line buffer and output sink
+struct Session {
+  Session(const char* name, Stream& stream, bool echo)
+    : name(name), stream(stream), sink(stream), echo(echo) {}
+
+  const char* name;
+  Stream& stream;
+  StreamSink sink;
+  String input;
+  bool echo;
+};
+
 class Command {
 public:
-  Command(const String& cmd, const String& description, std::function<void(const std::vector<String>&)> callback) 
-    : command(cmd), description(description), callback(callback) {}
+  Command(const String& cmd, const String& description, std::function<void(const std::vector<String>&)> callback, bool appContext = false) 
+    : command(cmd), description(description), callback(callback), appContext(appContext), calls(0), allocs{0, 0, 0}, lastAllocs{0, 0, 0} {}
   
   String command;
   String description;
   std::function<void(const std::vector<String>&)> callback;
+  bool appContext;  // Touches application state: runs in loop() when the CLI has its own task
+
+  // Dispatch statistics
+  uint32_t calls;
+  AllocCounters allocs;      // Total over all calls
+  AllocCounters lastAllocs;  // Last call only
 }; 
 
 class ESP32_CLI {
@@ -30,25 +61,182 @@ public:
   void begin(unsigned long baudRate = 115200);
 
 
+  // Default route for output issued outside of any command (boot messages...)
   inline void setInterface(OutputInterface interface){_interface = interface;};
   inline OutputInterface getCurrentInterface(){return _interface;};
   
+  // Output goes to the current sink, or the default route if there is none
   void print(const String& text);
   void println(const String& text);
+  void write(const char* data, size_t length);
+
+  // Sink of the session that issued the current command
+  inline OutputSink* getCurrentSink(){return context().sink;};
+
+  /**
+   * Input stream of the session that issued the current command, for
+   * commands that take over the session (file transfer)
+   * @return nullptr when not running on behalf of a session
+   */
+  Stream* getCurrentStream();
+
+  /**
+   * Drop all output to a sink (command output, broadcasts, logs) while a
+   * command talks to the session stream directly. Waits for a write in
+   * progress on another task to finish.
+   */
+  void muteSink(OutputSink* sink, bool mute);
+
+  /**
+   * Send output to another sink (e.g. to capture it or to answer a session
+   * from a scheduled task)
+   * @param sink New current sink, nullptr for the default route
+   * @return Previous current sink, to be restored by the caller
+   */
+  inline OutputSink* redirect(OutputSink* sink){OutputSink* prev = context().sink; context().sink = sink; return prev;};
+
+  /**
+   * Keep the current pipeline alive after the command returns. For commands
+   * that go on writing to the current sink from a scheduled task.
+   */
+  void holdOutput();
+
+  /**
+   * Stop writing to a sink kept with holdOutput(), flushing its pipeline
+   */
+  void releaseOutput(OutputSink* sink);
+
+  /**
+   * A pipeline stage (head) takes no more input from this sink's writer
+   */
+  bool isOutputClosed(OutputSink* sink);
+
+  // Output format of the current sink
+  void setFormat(OutputFormat format);
+  OutputFormat getFormat();
+  inline bool isJsonOutput(){return context().jsonOnce || getFormat() == OutputFormat::json;};
+
+  /**
+   * Set the "--json" flag of the running command, for commands re-run later
+   * @return Previous value
+   */
+  inline bool setJsonOnce(bool json){bool prev = context().jsonOnce; context().jsonOnce = json; return prev;};
+
+  /**
+   * Register a sink that can receive broadcasts
+   * @return false if the sink table is full
+   */
+  bool addSink(OutputSink* sink);
+  void removeSink(OutputSink* sink);
+
+  /**
+   * Subscribe or unsubscribe a sink to a broadcast topic
+   */
+  void subscribe(OutputSink* sink, Topic topic, bool enable);
+
+  // Cheap test to skip formatting broadcasts nobody receives
+  inline bool hasSubscribers(Topic topic) const {return (_topicMask & TOPIC_BIT(topic)) != 0;};
+
+  /**
+   * Write to every sink subscribed to a topic. In task mode this never
+   * waits for the CLI task: while it holds the output the message is
+   * dropped and counted instead.
+   */
+  void broadcast(Topic topic, const char* data, size_t length);
+  inline uint32_t getDroppedBroadcasts() const {return _droppedBroadcasts;};
   
   void update();  // Call this in loop()
+
+  /**
+   * Work is waiting for update(): session input, or in task mode a command
+   * queued for loop(). loop() must not block while this is true.
+   */
+  bool hasPendingInput();
+
+  /**
+   * Move input parsing, dispatch and output into a task pinned to a core.
+   * update() then only runs the commands flagged as application context.
+   * The task sleeps until serial input arrives (hooked by Idle.begin()) or,
+   * with the network up, until the next telnet poll.
+   * @param core Core to pin the CLI task to, not the one loop() runs on:
+   *             both tasks would share one output context
+   * @return true if the task was created
+   */
+  bool startTask(BaseType_t core);
+  inline bool isTaskMode() const {return _task != nullptr;};
+  inline BaseType_t getTaskCore() const {return _taskCore;};
+
+  // Latency between posting an application context command and its start
+  inline uint32_t getAppDispatches() const {return _appDispatches;};
+  inline uint32_t getAppLatencyMin() const {return _appLatencyMin;};
+  inline uint32_t getAppLatencyMax() const {return _appLatencyMax;};
+  inline uint32_t getAppLatencyMean() const {return _appDispatches ? _appLatencySum / _appDispatches : 0;};
+  inline uint32_t getAppTimeouts() const {return _appTimeouts;};
   
-  void addCommand(const String& command, const String& description, std::function<void(const std::vector<String>&)> callback);
+  void addCommand(const String& command, const String& description, std::function<void(const std::vector<String>&)> callback, bool appContext = false);
   void listCommands();
+  inline const std::vector<Command>& getCommands() const {return _commands;};
+  Command* findCommand(const String& command);
+  inline uint32_t getUnknownCommands() const {return _unknownCommands;};
   
   bool isClientConnected();
 
 private:
+  // Output state of the command running on a core
+  struct Context {
+    OutputSink* sink;
+    bool jsonOnce;  // "--json" given on the current command line
+  };
+
+  // Command handed from the CLI task to loop(). Heap allocated: if the CLI
+  // task stops waiting, loop() still owns it and deletes it when done.
+  struct AppRequest {
+    Command* command;
+    std::vector<String> args;
+    Context context;
+    int64_t postedUs;
+    bool done;       // loop() finished it, the CLI task will be signalled
+    bool abandoned;  // The CLI task timed out, loop() deletes it
+  };
+
   OutputInterface _interface;
-  String _inputBuffer;
+  Session _serial;
+  Session _telnet;
+  Context _context[portNUM_PROCESSORS];
+  OutputSink* _sinks[CLI_MAX_SINKS];
+  uint32_t _topicMask;  // Union of all sink subscriptions
+  uint32_t _unknownCommands;
   std::vector<Command> _commands;
+  Pipeline _pipe;
+
+  TaskHandle_t _task;
+  BaseType_t _taskCore;
+  QueueHandle_t _appQueue;
+  SemaphoreHandle_t _appDone;
+  portMUX_TYPE _appLock = portMUX_INITIALIZER_UNLOCKED;  // done/abandoned handshake
+  SemaphoreHandle_t _outputLock;
+  uint32_t _droppedBroadcasts;
+  uint32_t _appTimeouts;
+  uint32_t _appDispatches;
+  uint32_t _appLatencyMin;
+  uint32_t _appLatencyMax;
+  uint64_t _appLatencySum;
+
+  inline Context& context(){return _context[xPortGetCoreID()];};
+  inline void lockOutput(){if (_outputLock) xSemaphoreTakeRecursive(_outputLock, portMAX_DELAY);};
+  inline void unlockOutput(){if (_outputLock) xSemaphoreGiveRecursive(_outputLock);};
+  static void taskLoop(void* arg);
+  void poll();
+  void dispatch(Command& command, const std::vector<String>& args);
+  void runOnApp(Command& command, const std::vector<String>& args);
+  void serviceAppQueue();
   
+  void readSession(Session& session);
+  void writeDefault(const char* data, size_t length);
+  void updateTopicMask();
   void processCommand(const String& cmd);
+  bool beginPipe(const String& stages);
+  void endPipe();
   void help();
   std::vector<String> splitString(const String& input, char delimiter);
 };
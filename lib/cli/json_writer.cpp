@@ -0,0 +1,120 @@
+#include "json_writer.h"
+#include <math.h>
+
+JsonWriter::JsonWriter(char* buffer, size_t size)
+    : _buf(buffer), _size(size), _len(0), _needComma(false), _overflow(false) {
+    if (_size > 0) {
+        _buf[0] = '\0';
+    }
+}
+
+void JsonWriter::raw(const char* text, size_t len) {
+    if (_len + len >= _size) {
+        _overflow = true;
+        len = _size > _len + 1 ? _size - _len - 1 : 0;
+    }
+    memcpy(_buf + _len, text, len);
+    _len += len;
+    _buf[_len] = '\0';
+}
+
+void JsonWriter::raw(char c) {
+    raw(&c, 1);
+}
+
+void JsonWriter::number(const char* num, int len, size_t size) {
+    // snprintf() returns the untruncated length, or < 0 on error. A cut
+    // number would be wrong, not just short: report it as an overflow.
+    if (len < 0 || (size_t)len >= size) {
+        _overflow = true;
+        return;
+    }
+    raw(num, len);
+}
+
+void JsonWriter::string(const char* text) {
+    raw('"');
+    for (const char* p = text; *p; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            raw('\\');
+            raw(c);
+        } else if ((uint8_t)c < 0x20) {
+            char esc[7];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            raw(esc, 6);
+        } else {
+            raw(c);
+        }
+    }
+    raw('"');
+}
+
+void JsonWriter::key(const char* key) {
+    if (_needComma) {
+        raw(',');
+    }
+    if (key != nullptr) {
+        string(key);
+        raw(':');
+    }
+    _needComma = true;
+}
+
+void JsonWriter::beginObject(const char* name) {
+    key(name);
+    raw('{');
+    _needComma = false;
+}
+
+void JsonWriter::endObject() {
+    raw('}');
+    _needComma = true;
+}
+
+void JsonWriter::beginArray(const char* name) {
+    key(name);
+    raw('[');
+    _needComma = false;
+}
+
+void JsonWriter::endArray() {
+    raw(']');
+    _needComma = true;
+}
+
+void JsonWriter::add(const char* name, const char* value) {
+    key(name);
+    string(value);
+}
+
+void JsonWriter::add(const char* name, long value) {
+    char num[24];
+    key(name);
+    number(num, snprintf(num, sizeof(num), "%ld", value), sizeof(num));
+}
+
+void JsonWriter::add(const char* name, unsigned long value) {
+    char num[24];
+    key(name);
+    number(num, snprintf(num, sizeof(num), "%lu", value), sizeof(num));
+}
+
+void JsonWriter::add(const char* name, bool value) {
+    key(name);
+    if (value) {
+        raw("true", 4);
+    } else {
+        raw("false", 5);
+    }
+}
+
+void JsonWriter::add(const char* name, float value, uint8_t decimals) {
+    char num[24];
+    key(name);
+    if (!isfinite(value)) {
+        raw("null", 4);   // JSON has no NaN or Infinity
+        return;
+    }
+    number(num, snprintf(num, sizeof(num), "%.*f", decimals, (double)value), sizeof(num));
+}
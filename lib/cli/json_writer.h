@@ -0,0 +1,49 @@
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include <Arduino.h>
+
+/*
+* Single pass JSON serializer into a caller supplied buffer
+*
+* Values are appended in place; nothing is allocated. If the buffer is too
+* small, or a number does not fit its formatting buffer, the output is
+* incomplete and overflowed() returns true.
+*/
+class JsonWriter {
+    public:
+        JsonWriter(char* buffer, size_t size);
+
+        void beginObject(const char* key = nullptr);
+        void endObject();
+        void beginArray(const char* key = nullptr);
+        void endArray();
+
+        void add(const char* key, const char* value);
+        void add(const char* key, long value);
+        void add(const char* key, unsigned long value);
+        void add(const char* key, bool value);
+        void add(const char* key, float value, uint8_t decimals = 2);
+        // int32_t/uint32_t are long on Xtensa but int on most hosts
+        inline void add(const char* key, int value) { add(key, (long)value); }
+        inline void add(const char* key, unsigned value) { add(key, (unsigned long)value); }
+
+        inline const char* c_str() const { return _buf; }
+        inline size_t length() const { return _len; }
+        inline bool overflowed() const { return _overflow; }
+
+    private:
+        char* _buf;
+        size_t _size;
+        size_t _len;
+        bool _needComma;
+        bool _overflow;
+
+        void raw(const char* text, size_t len);
+        void raw(char c);
+        void number(const char* num, int len, size_t size);
+        void string(const char* text);
+        void key(const char* key);
+};
+
+#endif
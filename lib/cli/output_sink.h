@@ -0,0 +1,67 @@
+#ifndef __OUTPUT_SINK_H__
+#define __OUTPUT_SINK_H__
+
+#include <Arduino.h>
+
+enum class OutputFormat {
+  text,
+  json
+};
+
+// Unsolicited output a sink can subscribe to
+enum class Topic : uint8_t {
+  SENSOR_LOG = 0,
+  DEBUG_LOG,      // CLI_LOGx() messages
+  COUNT
+};
+
+#define TOPIC_BIT(topic) (1UL << static_cast<uint8_t>(topic))
+
+/*
+* Destination of command output
+*
+* Every session owns a sink; a command's output goes to the sink of the
+* session that issued it. Broadcast output only reaches sinks subscribed to
+* its topic.
+*/
+class OutputSink {
+public:
+  OutputSink() : format(OutputFormat::text), subscriptions(0), muted(false) {}
+  virtual ~OutputSink() {}
+
+  virtual void write(const char* data, size_t length) = 0;
+
+  OutputFormat format;
+  uint32_t subscriptions;  // TOPIC_BIT() mask
+  bool muted;              // Session taken over (file transfer): drop all output
+};
+
+// Sink writing to a serial port, telnet stream or socket
+class StreamSink : public OutputSink {
+public:
+  StreamSink(Print& out) : _out(out) {}
+
+  void write(const char* data, size_t length) override {
+    if (!muted) {
+      _out.write(reinterpret_cast<const uint8_t*>(data), length);
+    }
+  }
+
+private:
+  Print& _out;
+};
+
+// Sink appending to a String, used to capture a command's output
+class StringSink : public OutputSink {
+public:
+  StringSink(String& buffer) : _buffer(buffer) {}
+
+  void write(const char* data, size_t length) override {
+    _buffer.concat(data, length);
+  }
+
+private:
+  String& _buffer;
+};
+
+#endif
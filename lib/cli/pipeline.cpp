@@ -0,0 +1,192 @@
+#include "pipeline.h"
+
+static const char* OP_NAMES[] = {
+    "avg",
+    "min",
+    "max",
+    "threshold",
+    "head"
+};
+
+// Value of a record: the last number on the line ("ADC value: 1234" -> 1234)
+static bool lastNumber(const char* line, float& value) {
+    bool found = false;
+    const char* p = line;
+    while (*p) {
+        if (isdigit((unsigned char)*p) || ((*p == '-' || *p == '.') && isdigit((unsigned char)p[1]))) {
+            char* end;
+            float v = strtof(p, &end);
+            if (end > p) {
+                value = v;
+                found = true;
+                p = end;
+                continue;
+            }
+        }
+        p++;
+    }
+    return found;
+}
+
+PipeStage::PipeStage()
+    : _op(PipeOp::HEAD), _param(0), _below(false), _count(0), _acc(0),
+      _done(false), _next(nullptr), _lineLength(0) {
+    _line[0] = '\0';
+}
+
+bool PipeStage::configure(const std::vector<String>& args) {
+    if (args.size() < 2) {
+        return false;
+    }
+    int op = -1;
+    for (size_t i = 0; i < sizeof(OP_NAMES) / sizeof(OP_NAMES[0]); i++) {
+        if (args[0].equalsIgnoreCase(OP_NAMES[i])) {
+            op = i;
+            break;
+        }
+    }
+    if (op < 0) {
+        return false;
+    }
+
+    _op = static_cast<PipeOp>(op);
+    _param = args[1].toFloat();
+    _below = args.size() > 2 && args[2].equalsIgnoreCase("below");
+    _count = 0;
+    _acc = 0;
+    _done = false;
+    _lineLength = 0;
+    // Window and record counts must be positive
+    return _op == PipeOp::THRESHOLD || _param >= 1;
+}
+
+void PipeStage::write(const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            size_t lineLength = _lineLength;
+            _line[lineLength] = '\0';
+            _lineLength = 0;
+            record(_line, lineLength);
+        } else if (c != '\r' && _lineLength < sizeof(_line) - 1) {
+            _line[_lineLength++] = c;
+        }
+    }
+}
+
+void PipeStage::record(const char* line, size_t length) {
+    if (_done || _next == nullptr) {
+        return;
+    }
+    if (_op == PipeOp::HEAD) {
+        // Counts any line, numeric or not
+        _next->write(line, length);
+        _next->write("\r\n", 2);
+        if (++_count >= (uint32_t)_param) {
+            _done = true;
+        }
+        return;
+    }
+
+    float value;
+    if (!lastNumber(line, value)) {
+        return;
+    }
+    switch (_op) {
+        case PipeOp::THRESHOLD:
+            if (_below ? value < _param : value >= _param) {
+                _next->write(line, length);
+                _next->write("\r\n", 2);
+            }
+            return;
+        case PipeOp::AVG:
+            _acc += value;
+            break;
+        case PipeOp::MIN:
+            if (_count == 0 || value < _acc) _acc = value;
+            break;
+        case PipeOp::MAX:
+            if (_count == 0 || value > _acc) _acc = value;
+            break;
+        default:
+            break;
+    }
+    if (++_count >= (uint32_t)_param) {
+        flushWindow();
+    }
+}
+
+void PipeStage::finish() {
+    // A last record without line break
+    if (_lineLength > 0) {
+        write("\n", 1);
+    }
+    flushWindow();
+}
+
+void PipeStage::flushWindow() {
+    if (_count == 0 || _op == PipeOp::HEAD || _op == PipeOp::THRESHOLD) {
+        return;
+    }
+    emit(_op == PipeOp::AVG ? _acc / _count : _acc);
+    _count = 0;
+    _acc = 0;
+}
+
+void PipeStage::emit(float value) {
+    if (_next == nullptr) {
+        return;
+    }
+    char line[24];
+    int len = snprintf(line, sizeof(line), "%.2f\r\n", value);
+    _next->write(line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
+}
+
+void Pipeline::begin(OutputSink* out) {
+    _out = out;
+    _count = 0;
+    _active = true;
+    _held = false;
+}
+
+bool Pipeline::addStage(const std::vector<String>& args) {
+    if (_count >= PIPE_MAX_STAGES) {
+        return false;
+    }
+    PipeStage& stage = _stages[_count];
+    if (!stage.configure(args)) {
+        return false;
+    }
+    stage.setNext(_out);
+    if (_count > 0) {
+        _stages[_count - 1].setNext(&stage);
+    }
+    _count++;
+    return true;
+}
+
+void Pipeline::end() {
+    if (!_active) {
+        return;
+    }
+    // In order, so a flushed window still passes the later stages
+    for (uint8_t i = 0; i < _count; i++) {
+        _stages[i].finish();
+    }
+    _count = 0;
+    _active = false;
+    _held = false;
+}
+
+bool Pipeline::isClosed() const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_stages[i].isDone()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Pipeline::usage() {
+    return "Stages: avg <n>, min <n>, max <n>, threshold <value> [below], head <n>";
+}
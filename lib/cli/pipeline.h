@@ -0,0 +1,112 @@
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <Arduino.h>
+#include <vector>
+#include "output_sink.h"
+
+#define PIPE_MAX_STAGES  4
+#define PIPE_LINE_SIZE   64   // Longer records are truncated
+
+enum class PipeOp : uint8_t {
+    AVG,        // Mean of every n records
+    MIN,        // Minimum of every n records
+    MAX,        // Maximum of every n records
+    THRESHOLD,  // Records at or above a value (or below with "below")
+    HEAD        // First n records, then close the pipeline
+};
+
+/*
+* One streaming operator of a pipeline
+*
+* Receives the text output of the previous stage, splits it into line
+* records and takes the last number of each line as the record value.
+* Filters forward the original line, reducers emit one number per window.
+* State is a line buffer and a few accumulators, whatever the stream length.
+*/
+class PipeStage : public OutputSink {
+    public:
+        PipeStage();
+
+        void write(const char* data, size_t length) override;
+
+        /**
+         * Set up the stage from its arguments, e.g. {"avg", "100"}
+         * @return false if the operator or its arguments are invalid
+         */
+        bool configure(const std::vector<String>& args);
+
+        /**
+         * End of input: emit the pending record and partial window
+         */
+        void finish();
+
+        inline void setNext(OutputSink* next) { _next = next; }
+        inline bool isDone() const { return _done; }
+
+    private:
+        PipeOp _op;
+        float _param;
+        bool _below;
+        uint32_t _count;
+        float _acc;
+        bool _done;
+        OutputSink* _next;
+        char _line[PIPE_LINE_SIZE];
+        uint8_t _lineLength;
+
+        void record(const char* line, size_t length);
+        void flushWindow();
+        void emit(float value);
+};
+
+/*
+* Chain of stages between a source command and the session sink
+*/
+class Pipeline {
+    public:
+        Pipeline() : _count(0), _out(nullptr), _active(false), _held(false) {}
+
+        /**
+         * Start a new chain writing into out
+         */
+        void begin(OutputSink* out);
+
+        /**
+         * Append a stage
+         * @param args Stage operator and arguments
+         * @return false if the stage is invalid or the chain is full
+         */
+        bool addStage(const std::vector<String>& args);
+
+        /**
+         * Flush partial windows and detach from the output
+         */
+        void end();
+
+        /**
+         * Keep the chain alive after the source command returns, for sources
+         * that go on producing records (streams, watch)
+         */
+        inline void hold() { _held = true; }
+
+        inline OutputSink* head() { return _count > 0 ? &_stages[0] : _out; }
+        inline bool isActive() const { return _active; }
+        inline bool isHeld() const { return _held; }
+
+        /**
+         * A stage (head) will not take more input, the source should stop
+         */
+        bool isClosed() const;
+
+        static const char* usage();
+
+    private:
+        PipeStage _stages[PIPE_MAX_STAGES];
+        uint8_t _count;
+        OutputSink* _out;
+        bool _active;
+        bool _held;
+};
+
+#endif
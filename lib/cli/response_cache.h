@@ -0,0 +1,47 @@
+#ifndef __RESPONSE_CACHE_H__
+#define __RESPONSE_CACHE_H__
+
+#include <Arduino.h>
+
+/*
+* Rendered output of a command whose response rarely changes
+*
+* The owner renders the response into store() on a miss, then commit()s
+* it; later calls replay text() with a single write until invalidate().
+*/
+class ResponseCache {
+public:
+  ResponseCache(const char* name = "") : name(name), _valid(false), _hits(0), _misses(0) {}
+
+  /**
+   * Check for a cached response, counting the hit or miss
+   * @return true if text() can be replayed
+   */
+  inline bool lookup() {
+    if (_valid) {
+      _hits++;
+    } else {
+      _misses++;
+    }
+    return _valid;
+  }
+
+  // Buffer to render a new response into
+  inline String& store() {_text = ""; return _text;};
+  inline void commit() {_valid = true;};
+  inline void invalidate() {_valid = false;};
+
+  inline const String& text() const {return _text;};
+  inline uint32_t getHits() const {return _hits;};
+  inline uint32_t getMisses() const {return _misses;};
+
+  const char* name;
+
+private:
+  String _text;
+  bool _valid;
+  uint32_t _hits;
+  uint32_t _misses;
+};
+
+#endif
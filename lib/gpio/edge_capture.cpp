@@ -0,0 +1,133 @@
+#include "edge_capture.h"
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+
+#define RING_MASK (EDGE_CAPTURE_RING_SIZE - 1)
+
+// Create global instance
+EdgeCapture EdgeWatch;
+
+EdgeCapture::EdgeCapture()
+    : _head(0), _tail(0), _overflows(0), _active(false), _pin(0), _mode(CHANGE),
+      _overflowsSeen(0), _rising(0), _falling(0), _hasPrev(false), _hasPeriodRef(false), _periodRef(0) {
+    _period.reset();
+    _high.reset();
+    _low.reset();
+}
+
+void IRAM_ATTR EdgeCapture::onEdge(void* arg) {
+    EdgeCapture* self = static_cast<EdgeCapture*>(arg);
+    uint32_t cycles = ESP.getCycleCount();
+
+    uint32_t head = self->_head;
+    if (head - self->_tail >= EDGE_CAPTURE_RING_SIZE) {
+        self->_overflows++;
+        return;
+    }
+
+    uint8_t level;
+    if (self->_mode == RISING) {
+        level = 1;
+    } else if (self->_mode == FALLING) {
+        level = 0;
+    } else if (self->_pin < 32) {
+        level = (REG_READ(GPIO_IN_REG) >> self->_pin) & 1;
+    } else {
+        level = (REG_READ(GPIO_IN1_REG) >> (self->_pin - 32)) & 1;
+    }
+
+    Entry& entry = self->_ring[head & RING_MASK];
+    entry.cycles = cycles;
+    entry.level = level;
+    // Publish the entry before the new head
+    __atomic_store_n(&self->_head, head + 1, __ATOMIC_RELEASE);
+}
+
+bool EdgeCapture::start(uint8_t pin, int mode) {
+    if (_active) {
+        detachInterrupt(digitalPinToInterrupt(_pin));
+    }
+    if (pin > 39) {
+        _active = false;
+        return false;
+    }
+
+    _pin = pin;
+    _mode = mode;
+    _head = 0;
+    _tail = 0;
+    _overflows = 0;
+    _overflowsSeen = 0;
+    _rising = 0;
+    _falling = 0;
+    _hasPrev = false;
+    _hasPeriodRef = false;
+    _period.reset();
+    _high.reset();
+    _low.reset();
+
+    pinMode(pin, INPUT);
+    attachInterruptArg(digitalPinToInterrupt(pin), &EdgeCapture::onEdge, this, mode);
+    _active = true;
+    return true;
+}
+
+void EdgeCapture::stop() {
+    if (_active) {
+        detachInterrupt(digitalPinToInterrupt(_pin));
+        drain();
+    }
+    _active = false;
+}
+
+uint32_t EdgeCapture::drain() {
+    // Entries pending when an overflow is seen all predate the dropped edges
+    uint32_t overflows = _overflows;
+    uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    uint32_t start = _tail;
+    uint32_t tail = start;
+    // The period is measured between edges of the direction being watched,
+    // rising edges when watching both
+    uint8_t periodLevel = (_mode == FALLING) ? 0 : 1;
+
+    while (tail != head) {
+        const Entry& entry = _ring[tail & RING_MASK];
+
+        if (entry.level) {
+            _rising++;
+        } else {
+            _falling++;
+        }
+
+        if (_hasPrev && _prev.level != entry.level) {
+            uint32_t width = entry.cycles - _prev.cycles;
+            if (_prev.level) {
+                _high.add(width);
+            } else {
+                _low.add(width);
+            }
+        }
+
+        if (entry.level == periodLevel) {
+            if (_hasPeriodRef) {
+                _period.add(entry.cycles - _periodRef);
+            }
+            _periodRef = entry.cycles;
+            _hasPeriodRef = true;
+        }
+
+        _prev = entry;
+        _hasPrev = true;
+        tail++;
+    }
+
+    if (overflows != _overflowsSeen) {
+        // Durations across the gap would be wrong, restart the references
+        _overflowsSeen = overflows;
+        _hasPrev = false;
+        _hasPeriodRef = false;
+    }
+
+    __atomic_store_n(&_tail, tail, __ATOMIC_RELEASE);
+    return tail - start;
+}
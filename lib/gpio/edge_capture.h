@@ -0,0 +1,100 @@
+#ifndef __EDGE_CAPTURE_H__
+#define __EDGE_CAPTURE_H__
+
+#include <Arduino.h>
+
+#define EDGE_CAPTURE_RING_SIZE  256   // Must be a power of two
+
+/*
+* Summary of a series of durations, kept in CPU cycles
+*/
+struct EdgeStat {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+
+    void reset() { count = 0; min = UINT32_MAX; max = 0; sum = 0; }
+    void add(uint32_t value) {
+        count++;
+        sum += value;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+};
+
+/*
+* Interrupt driven edge capture on a single pin
+*
+* The ISR stores the cycle counter and pin level of each edge into a
+* single-producer/single-consumer ring; drain() folds the pending entries
+* into running statistics from task context. No interrupt is attached while
+* no watch is active.
+*/
+class EdgeCapture {
+    public:
+        EdgeCapture();
+
+        /**
+         * Start watching a pin (stops any previous watch)
+         * @param pin GPIO number
+         * @param mode RISING, FALLING or CHANGE
+         * @return true if the interrupt was attached
+         */
+        bool start(uint8_t pin, int mode);
+
+        /**
+         * Detach the interrupt, keeping the collected statistics
+         */
+        void stop();
+
+        /**
+         * Move pending ring entries into the statistics
+         * @return Number of edges drained
+         */
+        uint32_t drain();
+
+        inline bool isActive() const { return _active; }
+        inline uint8_t getPin() const { return _pin; }
+        inline int getMode() const { return _mode; }
+        inline uint32_t getOverflows() const { return _overflows; }
+        inline uint32_t getRising() const { return _rising; }
+        inline uint32_t getFalling() const { return _falling; }
+        inline const EdgeStat& getPeriod() const { return _period; }
+        inline const EdgeStat& getHighWidth() const { return _high; }
+        inline const EdgeStat& getLowWidth() const { return _low; }
+
+    private:
+        struct Entry {
+            uint32_t cycles;
+            uint8_t level;
+        };
+
+        Entry _ring[EDGE_CAPTURE_RING_SIZE];
+        volatile uint32_t _head;     // Written by the ISR only
+        volatile uint32_t _tail;     // Written by drain() only
+        volatile uint32_t _overflows;
+
+        bool _active;
+        uint8_t _pin;
+        int _mode;
+
+        // Drain side state
+        uint32_t _overflowsSeen;
+        uint32_t _rising;
+        uint32_t _falling;
+        bool _hasPrev;
+        Entry _prev;
+        bool _hasPeriodRef;
+        uint32_t _periodRef;
+        EdgeStat _period;
+        EdgeStat _high;
+        EdgeStat _low;
+
+        static void IRAM_ATTR onEdge(void* arg);
+};
+
+// Global instance
+extern EdgeCapture EdgeWatch;
+
+#endif
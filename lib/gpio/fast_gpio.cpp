@@ -0,0 +1,177 @@
+#include "fast_gpio.h"
+#include <esp_timer.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+
+#define MODE_UNKNOWN 0xFF
+
+// Create global instance
+FastGPIO GPIOFast;
+
+// Wave playback state shared with the timer ISR.
+// Each step is precomputed into the four register words it writes.
+struct WaveStep {
+    uint32_t set0;
+    uint32_t clr0;
+    uint32_t set1;
+    uint32_t clr1;
+};
+static WaveStep s_waveSteps[FAST_GPIO_WAVE_MAX_STEPS];
+static volatile uint8_t s_waveCount = 0;
+static volatile uint8_t s_waveIndex = 0;
+static volatile uint32_t s_wavePlayed = 0;
+
+FastGPIO::FastGPIO()
+    : _waveTimer(nullptr), _waveRate(0), _waveStartUs(0), _waveStopUs(0) {
+    memset(_mode, MODE_UNKNOWN, sizeof(_mode));
+}
+
+void FastGPIO::ensureMode(uint8_t pin, uint8_t mode) {
+    if (pin >= FAST_GPIO_PIN_COUNT) {
+        return;
+    }
+    if (_mode[pin] != mode) {
+        pinMode(pin, mode);
+        _mode[pin] = mode;
+    }
+}
+
+void FastGPIO::invalidateMode(uint8_t pin) {
+    if (pin < FAST_GPIO_PIN_COUNT) {
+        _mode[pin] = MODE_UNKNOWN;
+    }
+}
+
+bool FastGPIO::ensureOutput(uint64_t mask) {
+    if (mask == 0 || (mask & ~FAST_GPIO_OUTPUT_MASK) != 0) {
+        return false;
+    }
+    for (uint8_t pin = 0; pin < FAST_GPIO_PIN_COUNT; pin++) {
+        if (mask & (1ULL << pin)) {
+            ensureMode(pin, OUTPUT);
+        }
+    }
+    return true;
+}
+
+void FastGPIO::setMask(uint64_t mask) {
+    if ((uint32_t)mask) REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)mask);
+    if ((uint32_t)(mask >> 32)) REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(mask >> 32));
+}
+
+void FastGPIO::clearMask(uint64_t mask) {
+    if ((uint32_t)mask) REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)mask);
+    if ((uint32_t)(mask >> 32)) REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(mask >> 32));
+}
+
+void FastGPIO::toggleMask(uint64_t mask) {
+    uint64_t out = ((uint64_t)REG_READ(GPIO_OUT1_REG) << 32) | REG_READ(GPIO_OUT_REG);
+    writeMask(mask, ~out);
+}
+
+void FastGPIO::writeMask(uint64_t mask, uint64_t value) {
+    setMask(mask & value);
+    clearMask(mask & ~value);
+}
+
+uint64_t FastGPIO::readAll() {
+    return ((uint64_t)REG_READ(GPIO_IN1_REG) << 32) | REG_READ(GPIO_IN_REG);
+}
+
+void IRAM_ATTR FastGPIO::onWaveTick() {
+    const WaveStep& step = s_waveSteps[s_waveIndex];
+    REG_WRITE(GPIO_OUT_W1TS_REG, step.set0);
+    REG_WRITE(GPIO_OUT_W1TC_REG, step.clr0);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, step.set1);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, step.clr1);
+
+    uint8_t next = s_waveIndex + 1;
+    s_waveIndex = (next >= s_waveCount) ? 0 : next;
+    s_wavePlayed++;
+}
+
+bool FastGPIO::startWave(uint64_t mask, const uint64_t* steps, uint8_t count, uint32_t rateHz) {
+    if (count == 0 || count > FAST_GPIO_WAVE_MAX_STEPS) {
+        return false;
+    }
+    if (rateHz == 0 || rateHz > FAST_GPIO_WAVE_MAX_RATE) {
+        return false;
+    }
+    if (!ensureOutput(mask)) {
+        return false;
+    }
+
+    stopWave();
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t high = mask & steps[i];
+        uint64_t low = mask & ~steps[i];
+        s_waveSteps[i].set0 = (uint32_t)high;
+        s_waveSteps[i].clr0 = (uint32_t)low;
+        s_waveSteps[i].set1 = (uint32_t)(high >> 32);
+        s_waveSteps[i].clr1 = (uint32_t)(low >> 32);
+    }
+    s_waveCount = count;
+    s_waveIndex = 0;
+    s_wavePlayed = 0;
+
+    // 80 MHz APB / 80 = 1 MHz timer tick
+    _waveTimer = timerBegin(FAST_GPIO_WAVE_TIMER, 80, true);
+    if (_waveTimer == nullptr) {
+        return false;
+    }
+    _waveRate = rateHz;
+    _waveStartUs = esp_timer_get_time();
+    _waveStopUs = 0;
+    timerAttachInterrupt(_waveTimer, &FastGPIO::onWaveTick, true);
+    timerAlarmWrite(_waveTimer, 1000000UL / rateHz, true);
+    timerAlarmEnable(_waveTimer);
+    return true;
+}
+
+void FastGPIO::stopWave() {
+    if (_waveTimer == nullptr) {
+        return;
+    }
+    timerAlarmDisable(_waveTimer);
+    timerDetachInterrupt(_waveTimer);
+    timerEnd(_waveTimer);
+    _waveTimer = nullptr;
+    _waveStopUs = esp_timer_get_time();
+}
+
+uint32_t FastGPIO::getWaveSteps() const {
+    return s_wavePlayed;
+}
+
+float FastGPIO::getWaveMeasuredRate() const {
+    int64_t end = _waveStopUs != 0 ? _waveStopUs : esp_timer_get_time();
+    int64_t elapsed = end - _waveStartUs;
+    if (_waveStartUs == 0 || elapsed <= 0) {
+        return 0.0f;
+    }
+    return (float)s_wavePlayed * 1000000.0f / (float)elapsed;
+}
+
+uint32_t FastGPIO::benchRegister(uint8_t pin, uint32_t toggles) {
+    uint64_t mask = 1ULL << pin;
+    ensureMode(pin, OUTPUT);
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < toggles; i += 2) {
+        setMask(mask);
+        clearMask(mask);
+    }
+    return ESP.getCycleCount() - start;
+}
+
+uint32_t FastGPIO::benchDigitalWrite(uint8_t pin, uint32_t toggles) {
+    ensureMode(pin, OUTPUT);
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < toggles; i += 2) {
+        digitalWrite(pin, HIGH);
+        digitalWrite(pin, LOW);
+    }
+    return ESP.getCycleCount() - start;
+}
@@ -0,0 +1,121 @@
+#ifndef __FAST_GPIO_H__
+#define __FAST_GPIO_H__
+
+#include <Arduino.h>
+
+#define FAST_GPIO_PIN_COUNT        40
+#define FAST_GPIO_WAVE_MAX_STEPS   64
+#define FAST_GPIO_WAVE_MAX_RATE    100000UL   // Hz, bounded by ISR entry cost
+#define FAST_GPIO_WAVE_TIMER       1          // Hardware timer used by wave playback
+#define FAST_GPIO_BENCH_MAX_TOGGLES 1000000UL // Keeps a bench run well inside one CPU cycle counter wrap
+
+// Pins 34-39 are input only, 6-11 drive the SPI flash
+#define FAST_GPIO_OUTPUT_MASK      (0x00000003FFFFFFFFULL & ~0x0000000000000FC0ULL)
+
+/*
+* Direct register GPIO access
+*
+* Pins are addressed as a 64 bit mask (bit n = GPIO n). Writes go through the
+* W1TS/W1TC registers: all pins of a mask that go high change with one write
+* per 32 pin bank, then those that go low with another, so a mixed write is
+* not a single edge. The last pinMode() per pin is cached so repeated
+* commands skip it.
+*/
+class FastGPIO {
+    public:
+        FastGPIO();
+
+        /**
+         * Set the pin mode, calling pinMode() only if it differs from the cached mode
+         * @param pin GPIO number
+         * @param mode Arduino pin mode (INPUT, OUTPUT...)
+         */
+        void ensureMode(uint8_t pin, uint8_t mode);
+
+        /**
+         * Forget the cached mode of a pin (e.g. after external pinMode() calls)
+         * @param pin GPIO number
+         */
+        void invalidateMode(uint8_t pin);
+
+        /**
+         * Configure every pin of a mask as output
+         * @param mask Pin mask
+         * @return false if the mask contains pins that cannot drive an output
+         */
+        bool ensureOutput(uint64_t mask);
+
+        void setMask(uint64_t mask);
+        void clearMask(uint64_t mask);
+        void toggleMask(uint64_t mask);
+
+        /**
+         * Drive the pins of mask to the matching bits of value: a set write,
+         * then a clear write
+         * @param mask Pins to change
+         * @param value Wanted level for each pin
+         */
+        void writeMask(uint64_t mask, uint64_t value);
+
+        /**
+         * Read the input register of all pins
+         * @return Level of every pin as a mask
+         */
+        uint64_t readAll();
+
+        /**
+         * Start playing a pattern on the pins of mask from a hardware timer
+         * @param mask Pins driven by the pattern
+         * @param steps Pattern values, one per timer tick
+         * @param count Number of steps (1..FAST_GPIO_WAVE_MAX_STEPS)
+         * @param rateHz Step rate
+         * @return true if playback started
+         */
+        bool startWave(uint64_t mask, const uint64_t* steps, uint8_t count, uint32_t rateHz);
+
+        /**
+         * Stop pattern playback
+         */
+        void stopWave();
+
+        inline bool isWaveRunning() const { return _waveTimer != nullptr; }
+        inline uint32_t getWaveRate() const { return _waveRate; }
+
+        /**
+         * Number of steps played since the wave was started
+         */
+        uint32_t getWaveSteps() const;
+
+        /**
+         * Measured step rate of the current or last wave
+         * @return Steps per second
+         */
+        float getWaveMeasuredRate() const;
+
+        /**
+         * Toggle a pin through the set/clear registers and measure the rate
+         * @param pin GPIO number (must be output capable)
+         * @param toggles Number of toggles
+         * @return CPU cycles spent
+         */
+        uint32_t benchRegister(uint8_t pin, uint32_t toggles);
+
+        /**
+         * Same as benchRegister() but through digitalWrite()
+         */
+        uint32_t benchDigitalWrite(uint8_t pin, uint32_t toggles);
+
+    private:
+        uint8_t _mode[FAST_GPIO_PIN_COUNT];
+        hw_timer_t* _waveTimer;
+        uint32_t _waveRate;
+        int64_t _waveStartUs;
+        int64_t _waveStopUs;
+
+        static void IRAM_ATTR onWaveTick();
+};
+
+// Global instance
+extern FastGPIO GPIOFast;
+
+#endif
@@ -0,0 +1,90 @@
+#include "alloc_trace.h"
+
+// Create global instance
+AllocTracer AllocTrace;
+
+static volatile uint32_t s_allocs = 0;
+static volatile uint32_t s_frees = 0;
+static volatile uint32_t s_bytes = 0;
+
+#ifdef CLI_ALLOC_TRACE
+
+// Linker wrappers (-Wl,--wrap=malloc ...). They can run on both cores and
+// from ISRs, so counters are updated with atomic adds only.
+extern "C" {
+    void* __real_malloc(size_t size);
+    void* __real_calloc(size_t n, size_t size);
+    void* __real_realloc(void* ptr, size_t size);
+    void __real_free(void* ptr);
+
+    static inline void countAlloc(size_t size) {
+        __atomic_fetch_add(&s_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&s_bytes, (uint32_t)size, __ATOMIC_RELAXED);
+    }
+
+    void* __wrap_malloc(size_t size) {
+        void* ptr = __real_malloc(size);
+        if (ptr) countAlloc(size);
+        return ptr;
+    }
+
+    void* __wrap_calloc(size_t n, size_t size) {
+        void* ptr = __real_calloc(n, size);
+        if (ptr) countAlloc(n * size);
+        return ptr;
+    }
+
+    void* __wrap_realloc(void* ptr, size_t size) {
+        void* result = __real_realloc(ptr, size);
+        if (result) countAlloc(size);
+        return result;
+    }
+
+    void __wrap_free(void* ptr) {
+        if (ptr) __atomic_fetch_add(&s_frees, 1, __ATOMIC_RELAXED);
+        __real_free(ptr);
+    }
+}
+
+#endif
+
+AllocTracer::AllocTracer()
+    : _loopStart{0, 0, 0}, _loopTotal{0, 0, 0}, _loops(0), _loopsAllocating(0), _loopMaxAllocs(0) {
+}
+
+bool AllocTracer::isEnabled() const {
+#ifdef CLI_ALLOC_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocCounters AllocTracer::snapshot() const {
+    return { s_allocs, s_frees, s_bytes };
+}
+
+void AllocTracer::loopBegin() {
+    _loopStart = snapshot();
+}
+
+void AllocTracer::loopEnd() {
+    AllocCounters delta = snapshot() - _loopStart;
+    _loops++;
+    if (delta.allocs > 0) {
+        _loopsAllocating++;
+        _loopTotal.allocs += delta.allocs;
+        _loopTotal.frees += delta.frees;
+        _loopTotal.bytes += delta.bytes;
+        if (delta.allocs > _loopMaxAllocs) {
+            _loopMaxAllocs = delta.allocs;
+        }
+    }
+}
+
+void AllocTracer::resetLoopStats() {
+    _loopTotal = { 0, 0, 0 };
+    _loops = 0;
+    _loopsAllocating = 0;
+    _loopMaxAllocs = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef __ALLOC_TRACE_H__
+#define __ALLOC_TRACE_H__
+
+#include <Arduino.h>
+
+/*
+* Allocation counters
+*
+* Counting is compiled in with -DCLI_ALLOC_TRACE together with the linker
+* wrappers for malloc/calloc/realloc/free (see platformio.ini). Without the
+* flag every counter stays at zero and isEnabled() returns false.
+*/
+struct AllocCounters {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t bytes;
+
+    AllocCounters operator-(const AllocCounters& other) const {
+        return { allocs - other.allocs, frees - other.frees, bytes - other.bytes };
+    }
+};
+
+class AllocTracer {
+    public:
+        AllocTracer();
+
+        /**
+         * Check whether the allocation wrappers are compiled in
+         */
+        bool isEnabled() const;
+
+        /**
+         * Read the global counters
+         * @return Allocations, frees and bytes requested since boot
+         */
+        AllocCounters snapshot() const;
+
+        /**
+         * Mark the start of a loop() iteration
+         */
+        void loopBegin();
+
+        /**
+         * Mark the end of a loop() iteration and record its allocations
+         */
+        void loopEnd();
+
+        /**
+         * Reset the loop statistics
+         */
+        void resetLoopStats();
+
+        inline uint32_t getLoops() const { return _loops; }
+        inline uint32_t getLoopsAllocating() const { return _loopsAllocating; }
+        inline uint32_t getLoopMaxAllocs() const { return _loopMaxAllocs; }
+        inline const AllocCounters& getLoopTotal() const { return _loopTotal; }
+
+    private:
+        AllocCounters _loopStart;
+        AllocCounters _loopTotal;
+        uint32_t _loops;
+        uint32_t _loopsAllocating;
+        uint32_t _loopMaxAllocs;
+};
+
+// Global instance
+extern AllocTracer AllocTrace;
+
+#endif
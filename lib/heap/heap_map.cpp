@@ -0,0 +1,76 @@
+#include "heap_map.h"
+
+// Create global instance
+HeapMap HeapMaps;
+
+HeapMap::HeapMap() : _trendHead(0), _trendCount(0) {
+    memset(_trend, 0, sizeof(_trend));
+}
+
+uint8_t HeapMap::bucketOf(size_t size) {
+    uint8_t bucket = 0;
+    while (bucket < HEAP_MAP_BUCKETS - 1 && size >= bucketMin(bucket + 1)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+uint32_t HeapMap::bucketMin(uint8_t bucket) {
+    return (uint32_t)HEAP_MAP_MIN_BLOCK << (2 * bucket);
+}
+
+bool HeapMap::probe(uint32_t caps, FreeBlockHistogram& hist, size_t reserve) {
+    memset(&hist, 0, sizeof(hist));
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    if (info.free_blocks == 0) {
+        return false;
+    }
+
+    // Held on the stack, the probe must not allocate besides the probes
+    void* held[HEAP_MAP_MAX_PROBES];
+    uint8_t count = 0;
+    while (count < HEAP_MAP_MAX_PROBES) {
+        size_t largest = heap_caps_get_largest_free_block(caps);
+        if (largest < HEAP_MAP_MIN_BLOCK) {
+            break;
+        }
+        // PSRAM only probes do not touch internal RAM
+        if (heap_caps_get_free_size(caps) < largest + reserve ||
+            (caps != MALLOC_CAP_SPIRAM && heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < largest + reserve)) {
+            hist.reserveHit = true;
+            break;
+        }
+        void* block = heap_caps_malloc(largest, caps);
+        if (block == nullptr) {
+            break;
+        }
+        held[count++] = block;
+        hist.buckets[bucketOf(largest)]++;
+        hist.probedBytes += largest;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        heap_caps_free(held[i]);
+    }
+
+    hist.probed = count;
+    hist.rest = info.free_blocks > count ? info.free_blocks - count : 0;
+    hist.restBytes = info.total_free_bytes > hist.probedBytes ? info.total_free_bytes - hist.probedBytes : 0;
+    return true;
+}
+
+void HeapMap::sampleTrend() {
+    _trend[_trendHead] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    _trendHead = (_trendHead + 1) % HEAP_TREND_SIZE;
+    if (_trendCount < HEAP_TREND_SIZE) {
+        _trendCount++;
+    }
+}
+
+uint32_t HeapMap::getTrend(uint8_t index) const {
+    if (index >= _trendCount) {
+        return 0;
+    }
+    uint8_t oldest = (_trendHead + HEAP_TREND_SIZE - _trendCount) % HEAP_TREND_SIZE;
+    return _trend[(oldest + index) % HEAP_TREND_SIZE];
+}
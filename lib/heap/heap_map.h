@@ -0,0 +1,82 @@
+#ifndef __HEAP_MAP_H__
+#define __HEAP_MAP_H__
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#define HEAP_MAP_BUCKETS        7       // 16-63, 64-255 ... 16K-63K, 64K and up
+#define HEAP_MAP_MIN_BLOCK      16      // Smaller free blocks are not probed
+#define HEAP_MAP_MAX_PROBES     32      // Free blocks held at once while probing
+#define HEAP_MAP_RESERVE        16384   // Bytes probing always leaves free
+#define HEAP_TREND_SIZE         12
+#define HEAP_TREND_INTERVAL_MS  300000  // One largest block sample every 5 min
+
+// Free block size distribution of one heap capability
+struct FreeBlockHistogram {
+    uint16_t buckets[HEAP_MAP_BUCKETS];
+    uint16_t probed;         // Blocks counted in the buckets
+    uint32_t probedBytes;
+    uint16_t rest;           // Free blocks left: below HEAP_MAP_MIN_BLOCK, past the probe limit or the reserve
+    uint32_t restBytes;
+    bool reserveHit;         // Stopped to keep the reserve free
+};
+
+/*
+* Heap fragmentation report
+*
+* IDF 4.4 has no heap walk, so the free block sizes are probed: allocate the
+* largest free block, note its size, repeat, then free everything. Each probe
+* takes a whole free block, which gives the exact sizes of the largest
+* HEAP_MAP_MAX_PROBES blocks.
+*
+* Until they are freed, the probed blocks are gone for every other task,
+* including the Wi-Fi and lwIP tasks allocating on the other core: an
+* allocation there can fail while a probe runs. Probing therefore stops
+* before the free memory of the probed heap, or of internal RAM, would drop
+* below a reserve, and only runs when asked for ('memory map blocks').
+*
+* The largest free block of the default heap is also sampled periodically,
+* so a slow fragmentation drift shows up as a falling trend.
+*/
+class HeapMap {
+    public:
+        HeapMap();
+
+        /**
+         * Probe the free blocks of a heap capability
+         * @param caps MALLOC_CAP_xxx
+         * @param hist Result
+         * @param reserve Bytes to leave free in the heap and in internal RAM
+         * @return false if the heap has no free block
+         */
+        bool probe(uint32_t caps, FreeBlockHistogram& hist, size_t reserve = HEAP_MAP_RESERVE);
+
+        /**
+         * Record the current largest free block (call every HEAP_TREND_INTERVAL_MS)
+         */
+        void sampleTrend();
+
+        inline uint8_t getTrendCount() const { return _trendCount; }
+
+        /**
+         * Largest free block samples, oldest first
+         */
+        uint32_t getTrend(uint8_t index) const;
+
+        static uint8_t bucketOf(size_t size);
+
+        /**
+         * Lower bound of a bucket in bytes
+         */
+        static uint32_t bucketMin(uint8_t bucket);
+
+    private:
+        uint32_t _trend[HEAP_TREND_SIZE];
+        uint8_t _trendHead;     // Next slot to write
+        uint8_t _trendCount;
+};
+
+// Global instance
+extern HeapMap HeapMaps;
+
+#endif
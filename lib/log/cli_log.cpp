@@ -0,0 +1,97 @@
+#include "cli_log.h"
+#include <stdarg.h>
+#include <cli.h>
+
+// Create global instance
+Logger Log;
+
+static const char* MODULE_NAMES[] = {
+    "main",
+    "cli",
+    "wifi",
+    "gpio",
+    "sensor",
+    "fs"
+};
+
+static const char* LEVEL_NAMES[] = {
+    "none",
+    "error",
+    "warn",
+    "info",
+    "debug",
+    "verbose"
+};
+
+static const char LEVEL_TAGS[] = "-EWIDV";
+
+Logger::Logger() {
+    // Everything compiled in is enabled until filtered at runtime
+    memset(_levels, CLI_LOG_LEVEL, sizeof(_levels));
+}
+
+void Logger::log(LogModule module, uint8_t level, const char* format, ...) {
+    char line[CLI_LOG_LINE_SIZE];
+    int len = snprintf(line, sizeof(line), "[%c][%s] ", LEVEL_TAGS[level], moduleName(module));
+
+    va_list args;
+    va_start(args, format);
+    int body = vsnprintf(line + len, sizeof(line) - len, format, args);
+    va_end(args);
+    if (body < 0) {
+        // Encoding error: keep the tag so the call site is still visible
+        body = snprintf(line + len, sizeof(line) - len, "<bad format>");
+    }
+    len += body;
+    if (len > (int)sizeof(line) - 3) {
+        len = sizeof(line) - 3;   // Truncated, keep room for the line break
+    }
+    line[len++] = '\r';
+    line[len++] = '\n';
+
+    // Sessions subscribed to debug output get it; otherwise it goes to the
+    // current session or the default interface
+    if (CLI.hasSubscribers(Topic::DEBUG_LOG)) {
+        CLI.broadcast(Topic::DEBUG_LOG, line, len);
+    } else {
+        CLI.write(line, len);
+    }
+}
+
+void Logger::setLevel(LogModule module, uint8_t level) {
+    if (module < LogModule::COUNT) {
+        _levels[static_cast<uint8_t>(module)] = level > CLI_LOG_LEVEL ? CLI_LOG_LEVEL : level;
+    }
+}
+
+uint8_t Logger::getLevel(LogModule module) const {
+    return module < LogModule::COUNT ? _levels[static_cast<uint8_t>(module)] : CLI_LOG_LEVEL_NONE;
+}
+
+const char* Logger::moduleName(LogModule module) {
+    return module < LogModule::COUNT ? MODULE_NAMES[static_cast<uint8_t>(module)] : "unknown";
+}
+
+const char* Logger::levelName(uint8_t level) {
+    return level <= CLI_LOG_LEVEL_VERBOSE ? LEVEL_NAMES[level] : "unknown";
+}
+
+bool Logger::parseModule(const String& name, LogModule& module) {
+    for (uint8_t i = 0; i < static_cast<uint8_t>(LogModule::COUNT); i++) {
+        if (name.equalsIgnoreCase(MODULE_NAMES[i])) {
+            module = static_cast<LogModule>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::parseLevel(const String& name, uint8_t& level) {
+    for (uint8_t i = 0; i <= CLI_LOG_LEVEL_VERBOSE; i++) {
+        if (name.equalsIgnoreCase(LEVEL_NAMES[i])) {
+            level = i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,107 @@
+#ifndef __CLI_LOG_H__
+#define __CLI_LOG_H__
+
+#include <Arduino.h>
+
+#define CLI_LOG_LEVEL_NONE     0
+#define CLI_LOG_LEVEL_ERROR    1
+#define CLI_LOG_LEVEL_WARN     2
+#define CLI_LOG_LEVEL_INFO     3
+#define CLI_LOG_LEVEL_DEBUG    4
+#define CLI_LOG_LEVEL_VERBOSE  5
+
+// Minimum level compiled in. Calls below it expand to nothing, so neither
+// the call nor its format string end up in flash. Set with -DCLI_LOG_LEVEL=...
+#ifndef CLI_LOG_LEVEL
+#define CLI_LOG_LEVEL CLI_LOG_LEVEL_INFO
+#endif
+
+#define CLI_LOG_LINE_SIZE 128
+
+enum class LogModule : uint8_t {
+    MAIN = 0,
+    CLI,
+    WIFI,
+    GPIO,
+    SENSOR,
+    FS,
+    COUNT
+};
+
+/*
+* Runtime side of the log macros: per module level filter and formatting
+*/
+class Logger {
+    public:
+        Logger();
+
+        /**
+         * Check whether a message passes the runtime filter of its module
+         */
+        inline bool enabled(LogModule module, uint8_t level) const {
+            return level <= _levels[static_cast<uint8_t>(module)];
+        }
+
+        /**
+         * Format and emit a message, without checking the filter
+         */
+        void log(LogModule module, uint8_t level, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+        void setLevel(LogModule module, uint8_t level);
+        uint8_t getLevel(LogModule module) const;
+
+        static const char* moduleName(LogModule module);
+        static const char* levelName(uint8_t level);
+
+        /**
+         * Look up a module or level by its name
+         * @return false if the name is unknown
+         */
+        static bool parseModule(const String& name, LogModule& module);
+        static bool parseLevel(const String& name, uint8_t& level);
+
+    private:
+        uint8_t _levels[static_cast<uint8_t>(LogModule::COUNT)];
+};
+
+// Global instance
+extern Logger Log;
+
+#define CLI_LOG(module, level, format, ...) \
+    do { \
+        if (Log.enabled(LogModule::module, level)) { \
+            Log.log(LogModule::module, level, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#if CLI_LOG_LEVEL >= CLI_LOG_LEVEL_ERROR
+#define CLI_LOGE(module, format, ...) CLI_LOG(module, CLI_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define CLI_LOGE(module, format, ...) do {} while (0)
+#endif
+
+#if CLI_LOG_LEVEL >= CLI_LOG_LEVEL_WARN
+#define CLI_LOGW(module, format, ...) CLI_LOG(module, CLI_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define CLI_LOGW(module, format, ...) do {} while (0)
+#endif
+
+#if CLI_LOG_LEVEL >= CLI_LOG_LEVEL_INFO
+#define CLI_LOGI(module, format, ...) CLI_LOG(module, CLI_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define CLI_LOGI(module, format, ...) do {} while (0)
+#endif
+
+#if CLI_LOG_LEVEL >= CLI_LOG_LEVEL_DEBUG
+#define CLI_LOGD(module, format, ...) CLI_LOG(module, CLI_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define CLI_LOGD(module, format, ...) do {} while (0)
+#endif
+
+#if CLI_LOG_LEVEL >= CLI_LOG_LEVEL_VERBOSE
+#define CLI_LOGV(module, format, ...) CLI_LOG(module, CLI_LOG_LEVEL_VERBOSE, format, ##__VA_ARGS__)
+#else
+#define CLI_LOGV(module, format, ...) do {} while (0)
+#endif
+
+#endif
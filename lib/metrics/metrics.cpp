@@ -0,0 +1,87 @@
+#include "metrics.h"
+#include <stdarg.h>
+
+// Create global instance. It has no constructor so metrics defined in other
+// translation units can register before or after it is initialized.
+MetricsRegistry Metrics;
+
+static const char* TYPE_NAMES[] = {
+    "counter",
+    "gauge",
+    "histogram"
+};
+
+// Format into a line buffer and write it out in one call
+static void writeLine(Print& out, const char* format, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len > 0) {
+        out.write(reinterpret_cast<const uint8_t*>(line), len < (int)sizeof(line) ? len : sizeof(line) - 1);
+    }
+}
+
+Metric::Metric(const char* name, const char* help, MetricType type)
+    : name(name), help(help), type(type), next(nullptr) {
+    Metrics.add(this);
+}
+
+void Metric::renderHeader(Print& out) const {
+    writeLine(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, TYPE_NAMES[static_cast<int>(type)]);
+}
+
+void Counter::render(Print& out) const {
+    renderHeader(out);
+    writeLine(out, "%s %u\n", name, (unsigned)_value);
+}
+
+void Gauge::render(Print& out) const {
+    renderHeader(out);
+    writeLine(out, "%s %.9g\n", name, (double)_value);
+}
+
+Histogram::Histogram(const char* name, const char* help, const float* bounds, uint8_t count)
+    : Metric(name, help, MetricType::HISTOGRAM), _bounds(bounds),
+      _count(count > HISTOGRAM_MAX_BUCKETS ? HISTOGRAM_MAX_BUCKETS : count), _samples(0), _sum(0) {
+    memset(_buckets, 0, sizeof(_buckets));
+}
+
+void Histogram::observe(float value) {
+    uint8_t i = 0;
+    while (i < _count && value > _bounds[i]) {
+        i++;
+    }
+    _buckets[i]++;
+    _samples++;
+    _sum += value;
+}
+
+void Histogram::render(Print& out) const {
+    renderHeader(out);
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        cumulative += _buckets[i];
+        writeLine(out, "%s_bucket{le=\"%g\"} %u\n", name, (double)_bounds[i], (unsigned)cumulative);
+    }
+    cumulative += _buckets[_count];
+    writeLine(out, "%s_bucket{le=\"+Inf\"} %u\n", name, (unsigned)cumulative);
+    writeLine(out, "%s_sum %.15g\n%s_count %u\n", name, _sum, name, (unsigned)_samples);
+}
+
+void MetricsRegistry::add(Metric* metric) {
+    metric->next = nullptr;
+    if (_head == nullptr) {
+        _head = metric;
+    } else {
+        _tail->next = metric;
+    }
+    _tail = metric;
+}
+
+void MetricsRegistry::render(Print& out) const {
+    for (const Metric* metric = _head; metric != nullptr; metric = metric->next) {
+        metric->render(out);
+    }
+}
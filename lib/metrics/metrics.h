@@ -0,0 +1,109 @@
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <Arduino.h>
+
+enum class MetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+/*
+* Base class of all metrics
+*
+* Metrics are meant to be static objects: the constructor links them into
+* the global registry, so updating one never allocates or looks anything up.
+*/
+class Metric {
+    public:
+        Metric(const char* name, const char* help, MetricType type);
+        virtual ~Metric() {}
+
+        /**
+         * Write the metric in Prometheus text format
+         * @param out Destination stream
+         */
+        virtual void render(Print& out) const = 0;
+
+        const char* name;
+        const char* help;
+        MetricType type;
+        Metric* next;
+
+    protected:
+        /**
+         * Write the # HELP / # TYPE header
+         */
+        void renderHeader(Print& out) const;
+};
+
+class Counter : public Metric {
+    public:
+        Counter(const char* name, const char* help) : Metric(name, help, MetricType::COUNTER), _value(0) {}
+
+        inline void inc(uint32_t n = 1) { _value += n; }
+        inline uint32_t get() const { return _value; }
+        void render(Print& out) const override;
+
+    private:
+        volatile uint32_t _value;
+};
+
+class Gauge : public Metric {
+    public:
+        Gauge(const char* name, const char* help) : Metric(name, help, MetricType::GAUGE), _value(0) {}
+
+        inline void set(float value) { _value = value; }
+        inline float get() const { return _value; }
+        void render(Print& out) const override;
+
+    private:
+        volatile float _value;
+};
+
+#define HISTOGRAM_MAX_BUCKETS 12
+
+class Histogram : public Metric {
+    public:
+        /**
+         * @param bounds Upper bounds of the buckets, ascending (not copied)
+         * @param count Number of bounds (at most HISTOGRAM_MAX_BUCKETS)
+         */
+        Histogram(const char* name, const char* help, const float* bounds, uint8_t count);
+
+        void observe(float value);
+        void render(Print& out) const override;
+
+    private:
+        const float* _bounds;
+        uint8_t _count;
+        uint32_t _buckets[HISTOGRAM_MAX_BUCKETS + 1];  // Last one is +Inf
+        uint32_t _samples;
+        double _sum;    // A float sum stops growing once samples fall below its precision
+};
+
+class MetricsRegistry {
+    public:
+        /**
+         * Link a metric into the registry (called by the Metric constructor)
+         */
+        void add(Metric* metric);
+
+        /**
+         * Render every registered metric in Prometheus text format
+         * @param out Destination stream
+         */
+        void render(Print& out) const;
+
+        inline Metric* first() const { return _head; }
+
+    private:
+        Metric* _head;  // Zero initialized before any static constructor runs
+        Metric* _tail;
+};
+
+// Global instance
+extern MetricsRegistry Metrics;
+
+#endif
@@ -0,0 +1,131 @@
+#include "metrics_server.h"
+
+// Create global instance
+MetricsServer MetricsHttp;
+
+/*
+* Print adapter batching small writes into TCP sized chunks
+*/
+class ChunkedClientPrint : public Print {
+    public:
+        ChunkedClientPrint(WiFiClient& client) : _client(client), _len(0) {}
+        ~ChunkedClientPrint() { flush(); }
+
+        size_t write(uint8_t c) override {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t* data, size_t size) override {
+            for (size_t i = 0; i < size; i++) {
+                if (_len == sizeof(_buf)) {
+                    flush();
+                }
+                _buf[_len++] = data[i];
+            }
+            return size;
+        }
+
+        void flush() override {
+            if (_len > 0) {
+                _client.write(_buf, _len);
+                _len = 0;
+            }
+        }
+
+    private:
+        WiFiClient& _client;
+        uint8_t _buf[512];
+        size_t _len;
+};
+
+MetricsServer::MetricsServer(uint16_t port)
+    : _server(port), _started(false), _requests(0), _lineLen(0), _haveLine(false), _headerLen(0), _clientStart(0) {
+}
+
+void MetricsServer::begin() {
+    _server.begin();
+    _server.setNoDelay(true);
+    _started = true;
+}
+
+// "GET /metrics", optionally with a query, not "GET /metricsfoo"
+static bool isMetricsRequest(const char* line) {
+    static const char REQUEST[] = "GET /metrics";
+    const size_t len = sizeof(REQUEST) - 1;
+    return strncmp(line, REQUEST, len) == 0 && (line[len] == ' ' || line[len] == '?' || line[len] == '\0');
+}
+
+// Take what has arrived of the request, without waiting for more. The
+// request line is kept, header lines are only counted through.
+// @return true once the blank line ending the headers was read
+bool MetricsServer::readRequest() {
+    while (_client.available()) {
+        char c = _client.read();
+        if (c == '\r') {
+            continue;
+        }
+        if (c != '\n') {
+            if (!_haveLine && _lineLen < sizeof(_line) - 1) {
+                _line[_lineLen++] = c;
+            }
+            _headerLen++;
+            continue;
+        }
+        if (!_haveLine) {
+            // Empty lines before the request line are skipped
+            _line[_lineLen] = '\0';
+            _haveLine = _lineLen > 0;
+        } else if (_headerLen == 0) {
+            return true;
+        }
+        _headerLen = 0;
+    }
+    return false;
+}
+
+void MetricsServer::respond() {
+    if (isMetricsRequest(_line)) {
+        _requests++;
+        static const char HEADER[] =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4\r\n"
+            "Connection: close\r\n\r\n";
+        ChunkedClientPrint out(_client);
+        out.write(reinterpret_cast<const uint8_t*>(HEADER), sizeof(HEADER) - 1);
+        Metrics.render(out);
+    } else {
+        static const char NOT_FOUND[] =
+            "HTTP/1.0 404 Not Found\r\nConnection: close\r\n\r\n";
+        _client.write(reinterpret_cast<const uint8_t*>(NOT_FOUND), sizeof(NOT_FOUND) - 1);
+    }
+}
+
+void MetricsServer::update() {
+    if (!_started) {
+        return;
+    }
+    if (!_client) {
+        _client = _server.available();
+        if (!_client) {
+            return;
+        }
+        _lineLen = 0;
+        _haveLine = false;
+        _headerLen = 0;
+        _clientStart = millis();
+    }
+
+    bool complete = readRequest();
+    if (!complete && _client.connected() && millis() - _clientStart < METRICS_REQUEST_TIMEOUT) {
+        return;   // Come back on the next update()
+    }
+    // Headers cut short by a timeout or close still get an answer
+    if (_haveLine) {
+        respond();
+    }
+    // Anything sent after the headers, so the close is not a reset
+    while (_client.available()) {
+        _client.read();
+    }
+    _client.stop();
+}
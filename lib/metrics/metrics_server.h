@@ -0,0 +1,58 @@
+#ifndef __METRICS_SERVER_H__
+#define __METRICS_SERVER_H__
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "metrics.h"
+
+#define METRICS_SERVER_PORT        9100
+#define METRICS_REQUEST_TIMEOUT    200   // ms for a client to send its request
+#define METRICS_REQUEST_LINE_SIZE  64
+
+/*
+* Minimal HTTP listener serving GET /metrics
+*
+* One client is handled at a time. update() never waits for it: the request
+* line and headers are collected over as many calls as it takes to arrive,
+* then the response is rendered straight into the socket through a small
+* fixed buffer and the connection is closed. The whole request is read
+* first, lwIP answers a close with unread data by a reset that can make the
+* scraper drop the response.
+*/
+class MetricsServer {
+    public:
+        MetricsServer(uint16_t port = METRICS_SERVER_PORT);
+
+        /**
+         * Start listening (WiFi must be up)
+         */
+        void begin();
+
+        /**
+         * Serve a pending client, if any. Call this in loop()
+         */
+        void update();
+
+        inline uint32_t getRequests() const { return _requests; }
+
+    private:
+        WiFiServer _server;
+        bool _started;
+        uint32_t _requests;
+
+        // Client whose request is still arriving
+        WiFiClient _client;
+        char _line[METRICS_REQUEST_LINE_SIZE];   // Request line
+        uint8_t _lineLen;
+        bool _haveLine;          // Request line complete, reading headers
+        uint16_t _headerLen;     // Length of the header line being read
+        unsigned long _clientStart;
+
+        bool readRequest();
+        void respond();
+};
+
+// Global instance
+extern MetricsServer MetricsHttp;
+
+#endif
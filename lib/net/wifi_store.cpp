@@ -0,0 +1,137 @@
+#include "wifi_store.h"
+#include <cli_log.h>
+
+// Create global instance
+WifiStore WifiConfig;
+
+WifiStore::WifiStore()
+    : _channel(0), _staticIp(false), _ip(0), _gateway(0), _subnet(0), _dns(0), _connectMs(0), _fast(false) {
+    _ssid[0] = '\0';
+    _pass[0] = '\0';
+    memset(_bssid, 0, sizeof(_bssid));
+}
+
+bool WifiStore::load() {
+    Preferences prefs;
+    if (!prefs.begin(WIFI_STORE_NAMESPACE, true)) {
+        return false;
+    }
+    _ssid[0] = '\0';
+    _pass[0] = '\0';
+    prefs.getString("ssid", _ssid, sizeof(_ssid));
+    prefs.getString("pass", _pass, sizeof(_pass));
+    _channel = prefs.getUChar("channel", 0);
+    if (prefs.getBytes("bssid", _bssid, sizeof(_bssid)) != sizeof(_bssid)) {
+        _channel = 0; // No usable association without the BSSID
+    }
+    _staticIp = prefs.getBool("static", false);
+    _ip = prefs.getUInt("ip", 0);
+    _gateway = prefs.getUInt("gateway", 0);
+    _subnet = prefs.getUInt("subnet", 0);
+    _dns = prefs.getUInt("dns", 0);
+    prefs.end();
+    return hasCredentials();
+}
+
+bool WifiStore::save(bool staticIp) {
+    if (WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
+
+    strncpy(_ssid, WiFi.SSID().c_str(), sizeof(_ssid) - 1);
+    _ssid[sizeof(_ssid) - 1] = '\0';
+    strncpy(_pass, WiFi.psk().c_str(), sizeof(_pass) - 1);
+    _pass[sizeof(_pass) - 1] = '\0';
+    _channel = WiFi.channel();
+    uint8_t* bssid = WiFi.BSSID();
+    if (bssid != nullptr) {
+        memcpy(_bssid, bssid, sizeof(_bssid));
+    } else {
+        _channel = 0;
+    }
+    _staticIp = staticIp;
+    _ip = WiFi.localIP();
+    _gateway = WiFi.gatewayIP();
+    _subnet = WiFi.subnetMask();
+    _dns = WiFi.dnsIP();
+
+    Preferences prefs;
+    if (!prefs.begin(WIFI_STORE_NAMESPACE, false)) {
+        return false;
+    }
+    prefs.putString("ssid", _ssid);
+    prefs.putString("pass", _pass);
+    prefs.putUChar("channel", _channel);
+    prefs.putBytes("bssid", _bssid, sizeof(_bssid));
+    prefs.putBool("static", _staticIp);
+    prefs.putUInt("ip", _ip);
+    prefs.putUInt("gateway", _gateway);
+    prefs.putUInt("subnet", _subnet);
+    prefs.putUInt("dns", _dns);
+    prefs.end();
+    return true;
+}
+
+void WifiStore::forget() {
+    Preferences prefs;
+    if (prefs.begin(WIFI_STORE_NAMESPACE, false)) {
+        prefs.clear();
+        prefs.end();
+    }
+    _ssid[0] = '\0';
+    _pass[0] = '\0';
+    _channel = 0;
+    _staticIp = false;
+}
+
+bool WifiStore::waitConnected(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - start >= timeoutMs) {
+            return false;
+        }
+        delay(5);
+    }
+    return true;
+}
+
+bool WifiStore::connect() {
+    if (!hasCredentials()) {
+        return false;
+    }
+    uint32_t start = millis();
+    WiFi.mode(WIFI_STA);
+
+    if (_channel != 0) {
+        // Fast path: no scan, and no DHCP if an address was saved
+        if (_staticIp) {
+            WiFi.config(IPAddress(_ip), IPAddress(_gateway), IPAddress(_subnet), IPAddress(_dns));
+        }
+        WiFi.begin(_ssid, _pass, _channel, _bssid, true);
+        if (waitConnected(WIFI_FAST_TIMEOUT_MS)) {
+            _fast = true;
+            _connectMs = millis() - start;
+            return true;
+        }
+        // The AP moved or changed channel, fall back to DHCP and a full scan
+        CLI_LOGW(WIFI, "Fast connect to channel %u failed, scanning", _channel);
+        WiFi.disconnect();
+        if (_staticIp) {
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        }
+    }
+
+    bool connected = connect(_ssid, _pass);
+    _connectMs = millis() - start;
+    return connected;
+}
+
+bool WifiStore::connect(const char* ssid, const char* pass) {
+    uint32_t start = millis();
+    _fast = false;
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(ssid, pass);
+    bool connected = waitConnected(WIFI_FULL_TIMEOUT_MS);
+    _connectMs = millis() - start;
+    return connected;
+}
@@ -0,0 +1,83 @@
+#ifndef __WIFI_STORE_H__
+#define __WIFI_STORE_H__
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+#define WIFI_STORE_NAMESPACE      "wifi"
+#define WIFI_FAST_TIMEOUT_MS      1500   // Give up on the cached channel/BSSID after this
+#define WIFI_FULL_TIMEOUT_MS      15000
+
+/*
+* Wi-Fi credentials and last good association kept in NVS
+*
+* With a saved channel and BSSID the station skips the channel scan, and
+* with a saved static IP it also skips DHCP. If the fast path fails the
+* normal scan-and-associate path is used with the same credentials.
+*/
+class WifiStore {
+    public:
+        WifiStore();
+
+        /**
+         * Load the saved configuration from NVS
+         * @return true if credentials were found
+         */
+        bool load();
+
+        /**
+         * Save the credentials and association of the current connection
+         * @param staticIp Also save the current IP configuration and skip DHCP on boot
+         * @return false if not connected (check WiFi.status() first to
+         *         tell the two apart) or if NVS cannot be opened
+         */
+        bool save(bool staticIp);
+
+        /**
+         * Erase the saved configuration
+         */
+        void forget();
+
+        /**
+         * Connect using the saved configuration, fast path first
+         * @return true if connected
+         */
+        bool connect();
+
+        /**
+         * Connect with explicit credentials (scan, DHCP)
+         * @return true if connected
+         */
+        bool connect(const char* ssid, const char* pass);
+
+        inline bool hasCredentials() const { return _ssid[0] != '\0'; }
+        inline const char* getSSID() const { return _ssid; }
+        inline uint8_t getChannel() const { return _channel; }
+        inline bool hasStaticIp() const { return _staticIp; }
+
+        // Result of the last connect() call
+        inline uint32_t getConnectTime() const { return _connectMs; }
+        inline bool wasFastConnect() const { return _fast; }
+
+    private:
+        char _ssid[33];
+        char _pass[65];
+        uint8_t _channel;
+        uint8_t _bssid[6];
+        bool _staticIp;
+        uint32_t _ip;
+        uint32_t _gateway;
+        uint32_t _subnet;
+        uint32_t _dns;
+
+        uint32_t _connectMs;
+        bool _fast;
+
+        bool waitConnected(uint32_t timeoutMs);
+};
+
+// Global instance
+extern WifiStore WifiConfig;
+
+#endif
@@ -0,0 +1,133 @@
+#include "idle.h"
+#include <WiFi.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/uart.h>
+#endif
+
+// Create global instance
+IdleManager Idle;
+
+IdleManager::IdleManager() : _task(nullptr), _inputTask(nullptr), _lightSleep(false), _eventUs(0) {
+    _sinceUs = 0;
+    _idleUs = 0;
+    _eventWakes = 0;
+    _timerWakes = 0;
+    _latencyMin = UINT32_MAX;
+    _latencyMax = 0;
+    _latencySum = 0;
+    _latenessMax = 0;
+    _latenessSum = 0;
+}
+
+void IdleManager::begin(bool lightSleep) {
+    _task = xTaskGetCurrentTaskHandle();
+    resetStats();
+
+    // Serial input ends the wait; the callback runs in the UART event task
+    Serial.onReceive([this]() { inputReceived(); });
+
+    if (lightSleep) {
+        setLightSleep(true);
+    }
+}
+
+bool IdleManager::setLightSleep(bool enable) {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32_t pm;
+    pm.max_freq_mhz = getCpuFrequencyMhz();
+    pm.min_freq_mhz = enable ? getXtalFrequencyMhz() : getCpuFrequencyMhz();
+    pm.light_sleep_enable = enable;
+    if (esp_pm_configure(&pm) != ESP_OK) {
+        return false;
+    }
+    if (enable) {
+        // A few edges on RX wake the chip; those characters are lost
+        uart_set_wakeup_threshold(UART_NUM_0, 3);
+        esp_sleep_enable_uart_wakeup(UART_NUM_0);
+    }
+    _lightSleep = enable;
+    return true;
+#else
+    // The framework was built without power management (CONFIG_PM_ENABLE),
+    // blocking still lets the idle task clock-gate the core
+    _lightSleep = false;
+    return !enable;
+#endif
+}
+
+void IdleManager::wake() {
+    if (_eventUs == 0) {
+        _eventUs = esp_timer_get_time();
+    }
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);
+    }
+}
+
+void IdleManager::inputReceived() {
+    TaskHandle_t task = _inputTask;
+    if (task != nullptr) {
+        xTaskNotifyGive(task);
+    } else {
+        wake();
+    }
+}
+
+uint32_t IdleManager::getBlockLimit() const {
+    if (WiFi.status() != WL_CONNECTED) {
+        return IDLE_MAX_BLOCK_MS;
+    }
+    return _lightSleep ? IDLE_SLEEP_NET_POLL_MS : IDLE_NET_POLL_MS;
+}
+
+void IdleManager::wait(uint32_t maxMs) {
+    if (_task == nullptr || maxMs == 0) {
+        return;
+    }
+    uint32_t limit = getBlockLimit();
+    if (maxMs > limit) {
+        maxMs = limit;
+    }
+
+    int64_t start = esp_timer_get_time();
+    bool event = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maxMs)) != 0;
+    int64_t end = esp_timer_get_time();
+    _idleUs += end - start;
+
+    int64_t eventUs = _eventUs;
+    _eventUs = 0;
+    if (event && eventUs > start) {
+        // Input that arrived while running (eventUs <= start) was pending
+        // before the wait, it is neither a wake-up nor a latency sample
+        uint32_t latency = end - eventUs;
+        _eventWakes++;
+        _latencySum += latency;
+        if (latency < _latencyMin) _latencyMin = latency;
+        if (latency > _latencyMax) _latencyMax = latency;
+    } else if (!event) {
+        int64_t late = end - start - (int64_t)maxMs * 1000;
+        uint32_t lateness = late > 0 ? late : 0;
+        _timerWakes++;
+        _latenessSum += lateness;
+        if (lateness > _latenessMax) _latenessMax = lateness;
+    }
+}
+
+void IdleManager::resetStats() {
+    _sinceUs = esp_timer_get_time();
+    _idleUs = 0;
+    _eventWakes = 0;
+    _timerWakes = 0;
+    _latencyMin = UINT32_MAX;
+    _latencyMax = 0;
+    _latencySum = 0;
+    _latenessMax = 0;
+    _latenessSum = 0;
+}
+
+float IdleManager::getIdlePercent() const {
+    int64_t total = esp_timer_get_time() - _sinceUs;
+    return total > 0 ? 100.0f * _idleUs / total : 0;
+}
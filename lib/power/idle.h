@@ -0,0 +1,111 @@
+#ifndef __IDLE_H__
+#define __IDLE_H__
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+// Longest block while the network is up: telnet and HTTP sockets have no
+// wake-up event, so they are polled at this interval
+#define IDLE_NET_POLL_MS   20
+// The same with light sleep on: every poll is a wake-up, so socket input
+// waits longer in exchange for the chip actually sleeping
+#define IDLE_SLEEP_NET_POLL_MS  250
+// Longest block otherwise, bounds the damage of a missed event
+#define IDLE_MAX_BLOCK_MS  1000
+
+/*
+* Event driven idle for loop()
+*
+* wait() blocks the loop task on a task notification until the next
+* scheduler deadline, serial input (UART receive callback, unless another
+* task reads the input) or an explicit wake(). While blocked the FreeRTOS idle task runs, and with automatic
+* light sleep enabled the chip sleeps until the next timer or UART wake-up.
+* Time spent blocked and the delay from an event to the loop running again
+* are measured.
+*/
+class IdleManager {
+    public:
+        IdleManager();
+
+        /**
+         * Hook serial input and optionally enable automatic light sleep.
+         * Call from the task that calls wait(), after Serial.begin()
+         * @param lightSleep Enable automatic light sleep with UART wake-up
+         */
+        void begin(bool lightSleep);
+
+        /**
+         * Block until an event or until maxMs have passed
+         * @param maxMs Time until the next deadline, 0 to return at once
+         */
+        void wait(uint32_t maxMs);
+
+        /**
+         * Wake the waiting task (from another task, not from an ISR)
+         */
+        void wake();
+
+        /**
+         * Send serial input wake-ups to the task that reads the input (the
+         * CLI task) instead of the waiting one
+         * @param task nullptr to wake the waiting task again
+         */
+        inline void setInputTask(TaskHandle_t task) { _inputTask = task; }
+
+        /**
+         * Longest a task may block right now without missing socket input:
+         * sockets are polled while the network is up
+         */
+        uint32_t getBlockLimit() const;
+
+        /**
+         * Enable or disable automatic light sleep
+         * @return false if power management is not available in this build
+         */
+        bool setLightSleep(bool enable);
+        inline bool isLightSleep() const { return _lightSleep; }
+
+        void resetStats();
+
+        /**
+         * Share of time spent blocked since the last reset, in percent
+         */
+        float getIdlePercent() const;
+        inline uint32_t getStatsSeconds() const { return (esp_timer_get_time() - _sinceUs) / 1000000; }
+
+        inline uint32_t getEventWakes() const { return _eventWakes; }
+        inline uint32_t getTimerWakes() const { return _timerWakes; }
+
+        // Event to loop running again, in microseconds
+        inline uint32_t getLatencyMin() const { return _eventWakes ? _latencyMin : 0; }
+        inline uint32_t getLatencyMax() const { return _latencyMax; }
+        inline uint32_t getLatencyMean() const { return _eventWakes ? _latencySum / _eventWakes : 0; }
+
+        // Deadline to loop running again, in microseconds
+        inline uint32_t getLatenessMax() const { return _latenessMax; }
+        inline uint32_t getLatenessMean() const { return _timerWakes ? _latenessSum / _timerWakes : 0; }
+
+    private:
+        TaskHandle_t _task;
+        volatile TaskHandle_t _inputTask;
+        bool _lightSleep;
+        volatile int64_t _eventUs;   // Time of the last event, 0 when consumed
+        int64_t _sinceUs;
+        uint64_t _idleUs;
+        uint32_t _eventWakes;
+        uint32_t _timerWakes;
+        uint32_t _latencyMin;
+        uint32_t _latencyMax;
+        uint64_t _latencySum;
+        uint32_t _latenessMax;
+        uint64_t _latenessSum;
+
+        void inputReceived();
+};
+
+// Global instance
+extern IdleManager Idle;
+
+#endif
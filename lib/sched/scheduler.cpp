@@ -0,0 +1,82 @@
+#include "scheduler.h"
+
+// Create global instance
+Scheduler Sched;
+
+Scheduler::Scheduler() {
+    for (auto& task : _tasks) {
+        task.active = false;
+        task.period = 0;
+        task.last = 0;
+    }
+}
+
+int Scheduler::addTask(uint32_t periodMs, std::function<void()> callback) {
+    for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+        if (!_tasks[i].active) {
+            _tasks[i].period = periodMs;
+            _tasks[i].last = millis();
+            _tasks[i].callback = callback;
+            _tasks[i].active = true;
+            return i;
+        }
+    }
+    return -1; // Table full
+}
+
+bool Scheduler::removeTask(int id) {
+    if (id < 0 || id >= SCHED_MAX_TASKS || !_tasks[id].active) {
+        return false;
+    }
+    // The callback is released when the slot is reused, so a task may remove itself
+    _tasks[id].active = false;
+    return true;
+}
+
+bool Scheduler::setPeriod(int id, uint32_t periodMs) {
+    if (id < 0 || id >= SCHED_MAX_TASKS || !_tasks[id].active) {
+        return false;
+    }
+    _tasks[id].period = periodMs;
+    _tasks[id].last = millis();
+    return true;
+}
+
+void Scheduler::update() {
+    uint32_t now = millis();
+    for (auto& task : _tasks) {
+        if (task.active && now - task.last >= task.period) {
+            // Keep the phase unless we fell more than a period behind
+            task.last = (now - task.last >= 2 * task.period) ? now : task.last + task.period;
+            task.callback();
+        }
+    }
+}
+
+uint32_t Scheduler::getShortestPeriod() const {
+    uint32_t shortest = UINT32_MAX;
+    for (const auto& task : _tasks) {
+        if (task.active && task.period < shortest) {
+            shortest = task.period;
+        }
+    }
+    return shortest;
+}
+
+uint32_t Scheduler::timeToNext() const {
+    uint32_t now = millis();
+    uint32_t next = UINT32_MAX;
+    for (const auto& task : _tasks) {
+        if (!task.active) {
+            continue;
+        }
+        uint32_t elapsed = now - task.last;
+        if (elapsed >= task.period) {
+            return 0;
+        }
+        if (task.period - elapsed < next) {
+            next = task.period - elapsed;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,72 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <Arduino.h>
+#include <functional>
+
+#define SCHED_MAX_TASKS 8
+
+/*
+* Cooperative periodic task scheduler
+*
+* Tasks live in a fixed table and are run from loop() by update(); adding or
+* removing a task never allocates beyond the callback itself.
+*/
+class Scheduler {
+    public:
+        Scheduler();
+
+        /**
+         * Add a periodic task
+         * @param periodMs Period in milliseconds
+         * @param callback Function to run
+         * @return Task id, or -1 if the table is full
+         */
+        int addTask(uint32_t periodMs, std::function<void()> callback);
+
+        /**
+         * Remove a task
+         * @param id Task id returned by addTask()
+         * @return true if the task existed
+         */
+        bool removeTask(int id);
+
+        /**
+         * Change the period of a task, restarting its interval
+         * @param id Task id
+         * @param periodMs New period in milliseconds
+         * @return true if the task existed
+         */
+        bool setPeriod(int id, uint32_t periodMs);
+
+        /**
+         * Run every task that is due. Call this in loop()
+         */
+        void update();
+
+        /**
+         * Time until the next task is due
+         * @return Milliseconds, 0 if a task is due, UINT32_MAX if there is none
+         */
+        uint32_t timeToNext() const;
+
+        /**
+         * Shortest period of the active tasks, the most often loop() wakes up
+         * @return Milliseconds, UINT32_MAX if there is no task
+         */
+        uint32_t getShortestPeriod() const;
+
+    private:
+        struct Task {
+            bool active;
+            uint32_t period;
+            uint32_t last;
+            std::function<void()> callback;
+        };
+        Task _tasks[SCHED_MAX_TASKS];
+};
+
+// Global instance
+extern Scheduler Sched;
+
+#endif
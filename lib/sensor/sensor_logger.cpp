@@ -0,0 +1,143 @@
+#include "sensor_logger.h"
+#include <scheduler.h>
+
+// Create global instance
+SensorLogger Sensors;
+
+SensorLogger::SensorLogger() {
+    for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        _used[i] = false;
+        _channels[i].task = -1;
+    }
+}
+
+SensorChannel* SensorLogger::addChannel(const char* name, uint8_t pin, uint32_t sampleMs, uint32_t windowMs) {
+    if (find(name) != nullptr) {
+        return nullptr;
+    }
+    for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        if (_used[i]) {
+            continue;
+        }
+        SensorChannel& channel = _channels[i];
+        strncpy(channel.name, name, sizeof(channel.name) - 1);
+        channel.name[sizeof(channel.name) - 1] = '\0';
+        channel.pin = pin;
+        channel.sampleMs = sampleMs;
+        channel.windowMs = windowMs;
+        channel.task = -1;
+        channel.p50 = P2Quantile(0.5f);
+        channel.p90 = P2Quantile(0.9f);
+        channel.p99 = P2Quantile(0.99f);
+        channel.hasLast = false;
+        channel.enabled = false;
+        if (!setEnabled(&channel, true)) {
+            return nullptr;
+        }
+        _used[i] = true;
+        return &channel;
+    }
+    return nullptr;
+}
+
+bool SensorLogger::removeChannel(SensorChannel* channel) {
+    for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        if (_used[i] && &_channels[i] == channel) {
+            stopTask(_channels[i]);
+            _used[i] = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+SensorChannel* SensorLogger::find(const String& name) {
+    for (uint8_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        if (_used[i] && name.equalsIgnoreCase(_channels[i].name)) {
+            return &_channels[i];
+        }
+    }
+    return nullptr;
+}
+
+SensorChannel* SensorLogger::channel(uint8_t index) {
+    return index < SENSOR_MAX_CHANNELS && _used[index] ? &_channels[index] : nullptr;
+}
+
+bool SensorLogger::setSampleRate(SensorChannel* channel, uint32_t sampleMs) {
+    channel->sampleMs = sampleMs;
+    resetWindow(*channel);
+    if (channel->task >= 0) {
+        return Sched.setPeriod(channel->task, sampleMs);
+    }
+    return true;
+}
+
+void SensorLogger::setWindow(SensorChannel* channel, uint32_t windowMs) {
+    channel->windowMs = windowMs;
+    resetWindow(*channel);
+}
+
+bool SensorLogger::setEnabled(SensorChannel* channel, bool enabled) {
+    if (enabled == channel->enabled) {
+        return true;
+    }
+    if (enabled) {
+        resetWindow(*channel);
+        if (!startTask(*channel)) {
+            return false;
+        }
+    } else {
+        stopTask(*channel);
+    }
+    channel->enabled = enabled;
+    return true;
+}
+
+void SensorLogger::sample(SensorChannel& channel) {
+    float value = analogRead(channel.pin);
+    channel.stats.add(value);
+    channel.p50.add(value);
+    channel.p90.add(value);
+    channel.p99.add(value);
+
+    if (millis() - channel.windowStart < channel.windowMs) {
+        return;
+    }
+    WindowStats& last = channel.last;
+    last.count = channel.stats.count();
+    last.min = channel.stats.min();
+    last.max = channel.stats.max();
+    last.mean = channel.stats.mean();
+    last.stddev = channel.stats.stddev();
+    last.p50 = channel.p50.value();
+    last.p90 = channel.p90.value();
+    last.p99 = channel.p99.value();
+    channel.hasLast = true;
+    resetWindow(channel);
+
+    if (_callback) {
+        _callback(channel);
+    }
+}
+
+void SensorLogger::resetWindow(SensorChannel& channel) {
+    channel.windowStart = millis();
+    channel.stats.reset();
+    channel.p50.reset();
+    channel.p90.reset();
+    channel.p99.reset();
+}
+
+bool SensorLogger::startTask(SensorChannel& channel) {
+    SensorChannel* ch = &channel;
+    channel.task = Sched.addTask(channel.sampleMs, [this, ch]() { sample(*ch); });
+    return channel.task >= 0;
+}
+
+void SensorLogger::stopTask(SensorChannel& channel) {
+    if (channel.task >= 0) {
+        Sched.removeTask(channel.task);
+        channel.task = -1;
+    }
+}
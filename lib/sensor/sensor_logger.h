@@ -0,0 +1,118 @@
+#ifndef __SENSOR_LOGGER_H__
+#define __SENSOR_LOGGER_H__
+
+#include <Arduino.h>
+#include <functional>
+#include <stats.h>
+
+#define SENSOR_MAX_CHANNELS      4
+#define SENSOR_NAME_SIZE         12
+#define SENSOR_DEFAULT_SAMPLE_MS 10
+#define SENSOR_DEFAULT_WINDOW_MS 5000
+
+// Summary of one aggregation window
+struct WindowStats {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float stddev;
+    float p50;
+    float p90;
+    float p99;
+};
+
+// Analog input sampled at a fixed rate and summarized per window
+struct SensorChannel {
+    char name[SENSOR_NAME_SIZE];
+    uint8_t pin;
+    bool enabled;
+    uint32_t sampleMs;
+    uint32_t windowMs;
+    int task;               // Scheduler task id, -1 when not sampling
+    uint32_t windowStart;
+    RunningStats stats;
+    P2Quantile p50;
+    P2Quantile p90;
+    P2Quantile p99;
+    WindowStats last;       // Last completed window
+    bool hasLast;
+};
+
+/*
+* Periodic sensor logger
+*
+* Every channel samples from its own scheduler task and folds the samples
+* into running statistics and quantile sketches, so memory per channel is
+* fixed whatever the window length. At the end of a window the summary is
+* handed to the window callback and the accumulators start over.
+*/
+class SensorLogger {
+    public:
+        typedef std::function<void(const SensorChannel&)> WindowCallback;
+
+        SensorLogger();
+
+        /**
+         * Add a channel and start sampling it
+         * @param name Channel name
+         * @param pin Analog input pin
+         * @param sampleMs Sampling period in milliseconds
+         * @param windowMs Aggregation window in milliseconds
+         * @return Channel, or nullptr if the name is taken or the table is full
+         */
+        SensorChannel* addChannel(const char* name, uint8_t pin,
+                                  uint32_t sampleMs = SENSOR_DEFAULT_SAMPLE_MS,
+                                  uint32_t windowMs = SENSOR_DEFAULT_WINDOW_MS);
+
+        bool removeChannel(SensorChannel* channel);
+
+        /**
+         * Find a channel by name
+         * @return nullptr if there is no such channel
+         */
+        SensorChannel* find(const String& name);
+
+        /**
+         * Change the sampling period, restarting the window
+         * @return false if the scheduler has no free slot
+         */
+        bool setSampleRate(SensorChannel* channel, uint32_t sampleMs);
+
+        /**
+         * Change the window length, restarting the window
+         */
+        void setWindow(SensorChannel* channel, uint32_t windowMs);
+
+        /**
+         * Start or stop sampling a channel
+         * @return false if the scheduler has no free slot
+         */
+        bool setEnabled(SensorChannel* channel, bool enabled);
+
+        /**
+         * Set the function called with each completed window
+         */
+        inline void onWindow(WindowCallback callback) { _callback = callback; }
+
+        /**
+         * Channel slot by index, for listing
+         * @return nullptr if the slot is unused
+         */
+        SensorChannel* channel(uint8_t index);
+
+    private:
+        SensorChannel _channels[SENSOR_MAX_CHANNELS];
+        bool _used[SENSOR_MAX_CHANNELS];
+        WindowCallback _callback;
+
+        void sample(SensorChannel& channel);
+        void resetWindow(SensorChannel& channel);
+        bool startTask(SensorChannel& channel);
+        void stopTask(SensorChannel& channel);
+};
+
+// Global instance
+extern SensorLogger Sensors;
+
+#endif
@@ -0,0 +1,125 @@
+#include "system_state.h"
+#include <TimeLib.h>
+#include <scheduler.h>
+
+// Create global instance
+SystemState State;
+
+static const char* FIELD_NAMES[] = {
+    "wifi",
+    "rssi",
+    "heap",
+    "time"
+};
+
+SystemState::SystemState() : _seq(0) {
+    memset(&_data, 0, sizeof(_data));
+}
+
+void SystemState::begin() {
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onWiFiEvent(event, info); });
+
+    // Wi-Fi may already be up
+    if (WiFi.status() == WL_CONNECTED) {
+        String ssid = WiFi.SSID();
+        uint32_t ip = WiFi.localIP();
+        uint8_t channel = WiFi.channel();
+        beginWrite();
+        _data.connected = true;
+        strncpy(_data.ssid, ssid.c_str(), sizeof(_data.ssid) - 1);
+        _data.ip = ip;
+        _data.channel = channel;
+        _data.updated[static_cast<uint8_t>(StateField::WIFI)] = millis();
+        endWrite();
+    }
+
+    tick();
+    Sched.addTask(STATE_TICK_MS, [this]() { tick(); });
+}
+
+void SystemState::beginWrite() {
+    portENTER_CRITICAL(&_writeLock);
+    __atomic_store_n(&_seq, _seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void SystemState::endWrite() {
+    __atomic_store_n(&_seq, _seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&_writeLock);
+}
+
+void SystemState::read(SystemSnapshot& out) const {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&_seq, __ATOMIC_ACQUIRE);
+        memcpy(&out, &_data, sizeof(out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&_seq, __ATOMIC_RELAXED));
+}
+
+void SystemState::tick() {
+    // Query the drivers outside the write section
+    bool connected = WiFi.status() == WL_CONNECTED;
+    int8_t rssi = connected ? WiFi.RSSI() : 0;
+    uint32_t heap = ESP.getFreeHeap();
+    time_t t = now();
+    char timestamp[STATE_TIMESTAMP_SIZE];
+    snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02d %02d:%02d:%02d",
+             year(t), month(t), day(t), hour(t), minute(t), second(t));
+    uint32_t ms = millis();
+
+    beginWrite();
+    if (connected) {
+        _data.rssi = rssi;
+        _data.updated[static_cast<uint8_t>(StateField::RSSI)] = ms;
+    }
+    _data.heapFree = heap;
+    _data.updated[static_cast<uint8_t>(StateField::HEAP)] = ms;
+    memcpy(_data.timestamp, timestamp, sizeof(timestamp));
+    _data.updated[static_cast<uint8_t>(StateField::TIME)] = ms;
+    endWrite();
+}
+
+void SystemState::onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+    uint32_t ms = millis();
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED: {
+            const wifi_event_sta_connected_t& sta = info.wifi_sta_connected;
+            size_t len = sta.ssid_len < sizeof(_data.ssid) - 1 ? sta.ssid_len : sizeof(_data.ssid) - 1;
+            beginWrite();
+            memcpy(_data.ssid, sta.ssid, len);
+            _data.ssid[len] = '\0';
+            _data.channel = sta.channel;
+            _data.updated[static_cast<uint8_t>(StateField::WIFI)] = ms;
+            endWrite();
+            break;
+        }
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            beginWrite();
+            _data.connected = true;
+            _data.ip = info.got_ip.ip_info.ip.addr;
+            _data.updated[static_cast<uint8_t>(StateField::WIFI)] = ms;
+            endWrite();
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            beginWrite();
+            _data.connected = false;
+            _data.ip = 0;
+            _data.rssi = 0;
+            _data.updated[static_cast<uint8_t>(StateField::WIFI)] = ms;
+            endWrite();
+            break;
+        default:
+            break;
+    }
+}
+
+uint32_t SystemState::age(const SystemSnapshot& snapshot, StateField field) {
+    uint32_t updated = snapshot.updated[static_cast<uint8_t>(field)];
+    return updated == 0 ? UINT32_MAX : millis() - updated;
+}
+
+const char* SystemState::fieldName(StateField field) {
+    return field < StateField::COUNT ? FIELD_NAMES[static_cast<uint8_t>(field)] : "unknown";
+}
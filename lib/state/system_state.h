@@ -0,0 +1,81 @@
+#ifndef __SYSTEM_STATE_H__
+#define __SYSTEM_STATE_H__
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+
+#define STATE_TICK_MS        1000
+#define STATE_TIMESTAMP_SIZE 20   // "YYYY-MM-DD HH:MM:SS"
+
+// Field groups of the snapshot, each with its own update time
+enum class StateField : uint8_t {
+    WIFI = 0,   // connected, ssid, ip, channel: Wi-Fi events
+    RSSI,       // tick while connected
+    HEAP,       // tick
+    TIME,       // tick
+    COUNT
+};
+
+// Copy of the system state handed to readers
+struct SystemSnapshot {
+    bool connected;
+    char ssid[33];
+    uint32_t ip;
+    uint8_t channel;
+    int8_t rssi;
+    uint32_t heapFree;
+    char timestamp[STATE_TIMESTAMP_SIZE];
+    uint32_t updated[static_cast<uint8_t>(StateField::COUNT)];  // millis(), 0 = never
+};
+
+/*
+* System state shared by status, metrics and logging
+*
+* Wi-Fi fields follow WiFi.onEvent() callbacks; RSSI, heap and the
+* formatted timestamp are refreshed by a scheduler tick. Readers copy the
+* whole snapshot under a sequence counter instead of querying the drivers:
+* they never block, and retry in the rare case a writer ran meanwhile.
+*/
+class SystemState {
+    public:
+        SystemState();
+
+        /**
+         * Register the Wi-Fi event handler and the tick. Call before Wi-Fi
+         * is started so the connection events are seen
+         */
+        void begin();
+
+        /**
+         * Get a consistent copy of the current state
+         */
+        void read(SystemSnapshot& out) const;
+
+        /**
+         * Milliseconds since a field group of a snapshot was updated
+         * @return UINT32_MAX if it never was
+         */
+        static uint32_t age(const SystemSnapshot& snapshot, StateField field);
+
+        static const char* fieldName(StateField field);
+
+        /**
+         * Refresh the ticked fields now
+         */
+        void tick();
+
+    private:
+        SystemSnapshot _data;
+        uint32_t _seq;              // Odd while a write is in progress
+        portMUX_TYPE _writeLock = portMUX_INITIALIZER_UNLOCKED;  // Writers: event task and loop()
+
+        void beginWrite();
+        void endWrite();
+        void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
+};
+
+// Global instance
+extern SystemState State;
+
+#endif
@@ -0,0 +1,118 @@
+#include "stats.h"
+#include <math.h>
+
+void RunningStats::reset() {
+    _count = 0;
+    _min = 0;
+    _max = 0;
+    _mean = 0;
+    _m2 = 0;
+}
+
+void RunningStats::add(float x) {
+    _count++;
+    if (_count == 1) {
+        _min = x;
+        _max = x;
+    } else {
+        if (x < _min) _min = x;
+        if (x > _max) _max = x;
+    }
+    float delta = x - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (x - _mean);
+}
+
+float RunningStats::stddev() const {
+    return _count > 1 ? sqrtf(_m2 / (_count - 1)) : 0;
+}
+
+void P2Quantile::reset() {
+    _count = 0;
+    for (int i = 0; i < 5; i++) {
+        _q[i] = 0;
+        _n[i] = i;
+    }
+    _np[0] = 0;
+    _np[1] = 2 * _p;
+    _np[2] = 4 * _p;
+    _np[3] = 2 + 2 * _p;
+    _np[4] = 4;
+    _dn[0] = 0;
+    _dn[1] = _p / 2;
+    _dn[2] = _p;
+    _dn[3] = (1 + _p) / 2;
+    _dn[4] = 1;
+}
+
+void P2Quantile::add(float x) {
+    // The first five samples become the markers, kept sorted
+    if (_count < 5) {
+        int i = _count++;
+        while (i > 0 && _q[i - 1] > x) {
+            _q[i] = _q[i - 1];
+            i--;
+        }
+        _q[i] = x;
+        return;
+    }
+    _count++;
+
+    // Cell of the new sample, extending the extremes if needed
+    int k;
+    if (x < _q[0]) {
+        _q[0] = x;
+        k = 0;
+    } else if (x >= _q[4]) {
+        _q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= _q[k + 1]) {
+            k++;
+        }
+    }
+    for (int i = k + 1; i < 5; i++) {
+        _n[i]++;
+    }
+    for (int i = 0; i < 5; i++) {
+        _np[i] += _dn[i];
+    }
+
+    // Move the middle markers toward their desired positions
+    for (int i = 1; i <= 3; i++) {
+        float d = _np[i] - _n[i];
+        if ((d >= 1 && _n[i + 1] - _n[i] > 1) || (d <= -1 && _n[i - 1] - _n[i] < -1)) {
+            int s = d > 0 ? 1 : -1;
+            float q = parabolic(i, s);
+            if (_q[i - 1] < q && q < _q[i + 1]) {
+                _q[i] = q;
+            } else {
+                _q[i] = linear(i, s);
+            }
+            _n[i] += s;
+        }
+    }
+}
+
+float P2Quantile::parabolic(int i, float d) const {
+    return _q[i] + d / (_n[i + 1] - _n[i - 1]) *
+           ((_n[i] - _n[i - 1] + d) * (_q[i + 1] - _q[i]) / (_n[i + 1] - _n[i]) +
+            (_n[i + 1] - _n[i] - d) * (_q[i] - _q[i - 1]) / (_n[i] - _n[i - 1]));
+}
+
+float P2Quantile::linear(int i, int d) const {
+    return _q[i] + d * (_q[i + d] - _q[i]) / (_n[i + d] - _n[i]);
+}
+
+float P2Quantile::value() const {
+    if (_count == 0) {
+        return 0;
+    }
+    if (_count < 5) {
+        // Exact on the sorted samples so far
+        int i = (int)lroundf(_p * (_count - 1));
+        return _q[i];
+    }
+    return _q[2];
+}
@@ -0,0 +1,71 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <Arduino.h>
+
+/*
+* Streaming count/min/max/mean/standard deviation (Welford's method)
+*
+* Numerically stable in a single pass, without keeping the samples.
+*/
+class RunningStats {
+    public:
+        RunningStats() { reset(); }
+
+        void reset();
+        void add(float x);
+
+        inline uint32_t count() const { return _count; }
+        inline float min() const { return _min; }
+        inline float max() const { return _max; }
+        inline float mean() const { return _mean; }
+
+        /**
+         * Sample standard deviation
+         * @return 0 with less than two samples
+         */
+        float stddev() const;
+
+    private:
+        uint32_t _count;
+        float _min;
+        float _max;
+        float _mean;
+        float _m2;      // Sum of squared differences from the mean
+};
+
+/*
+* Streaming quantile estimate (P-square algorithm, Jain & Chlamtac)
+*
+* Tracks five markers whose heights converge to the minimum, p/2, p,
+* (1+p)/2 quantiles and the maximum, so memory does not grow with the
+* number of samples.
+*/
+class P2Quantile {
+    public:
+        P2Quantile(float p = 0.5f) : _p(p) { reset(); }
+
+        void reset();
+        void add(float x);
+
+        /**
+         * Current estimate of the p quantile
+         * @return 0 before the first sample
+         */
+        float value() const;
+
+        inline float quantile() const { return _p; }
+
+    private:
+        float _p;
+        uint32_t _count;
+        float _q[5];    // Marker heights
+        float _n[5];    // Marker positions
+        float _np[5];   // Desired positions
+        float _dn[5];   // Desired position increments
+
+        float parabolic(int i, float d) const;
+        float linear(int i, int d) const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "task_monitor.h"
+
+// Create global instance
+TaskMonitor Tasks;
+
+static bool ranksBefore(const TaskLoad& a, const TaskLoad& b) {
+#if TASK_MONITOR_CPU
+    return a.cpu > b.cpu;
+#else
+    return a.priority > b.priority;
+#endif
+}
+
+TaskMonitor::TaskMonitor() : _current(0), _prevCount(0), _prevTotal(0), _count(0), _interval(0), _overflow(false) {
+    for (uint8_t i = 0; i < portNUM_PROCESSORS; i++) {
+        _coreBusy[i] = 0;
+    }
+}
+
+bool TaskMonitor::sample() {
+#if TASK_MONITOR_AVAILABLE
+    uint8_t next = _current ^ 1;
+    TaskStatus_t* curr = _snapshots[next];
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(curr, TASK_MONITOR_MAX_TASKS, &total);
+    _overflow = count == 0;
+    if (count == 0) {
+        return false;   // More tasks than snapshot slots
+    }
+
+#if TASK_MONITOR_CPU
+    const TaskStatus_t* prev = _snapshots[_current];
+    UBaseType_t prevCount = _prevCount;
+#endif
+    uint32_t interval = total - _prevTotal;
+    _current = next;
+    _prevCount = count;
+    _prevTotal = total;
+#if TASK_MONITOR_CPU
+    if (prevCount == 0 || interval == 0) {
+        return false;
+    }
+#endif
+
+    _interval = interval;
+    _count = count;
+    for (uint8_t i = 0; i < portNUM_PROCESSORS; i++) {
+        _coreBusy[i] = 0;
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t& task = curr[i];
+        TaskLoad& load = _loads[i];
+        strncpy(load.name, task.pcTaskName, sizeof(load.name) - 1);
+        load.name[sizeof(load.name) - 1] = '\0';
+        load.priority = task.uxCurrentPriority;
+        load.state = task.eCurrentState;
+#if configTASKLIST_INCLUDE_COREID
+        load.core = task.xCoreID == tskNO_AFFINITY ? -1 : task.xCoreID;
+#else
+        load.core = -1;
+#endif
+        load.stackFree = task.usStackHighWaterMark;
+
+#if TASK_MONITOR_CPU
+        // Tasks created since the last snapshot count from zero
+        uint32_t before = 0;
+        for (UBaseType_t j = 0; j < prevCount; j++) {
+            if (prev[j].xTaskNumber == task.xTaskNumber) {
+                before = prev[j].ulRunTimeCounter;
+                break;
+            }
+        }
+        load.cpu = 100.0f * (task.ulRunTimeCounter - before) / interval;
+
+        for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+            if (task.xHandle == xTaskGetIdleTaskHandleForCPU(core)) {
+                _coreBusy[core] = load.cpu < 100.0f ? 100.0f - load.cpu : 0;
+            }
+        }
+#else
+        load.cpu = 0;
+#endif
+
+        // Insert into the busiest first order
+        uint8_t pos = i;
+        while (pos > 0 && ranksBefore(load, _loads[_order[pos - 1]])) {
+            _order[pos] = _order[pos - 1];
+            pos--;
+        }
+        _order[pos] = i;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef __TASK_MONITOR_H__
+#define __TASK_MONITOR_H__
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define TASK_MONITOR_MAX_TASKS 24
+
+// Listing tasks needs the FreeRTOS trace facility, their CPU time also
+// needs run time statistics
+#if configUSE_TRACE_FACILITY
+#define TASK_MONITOR_AVAILABLE 1
+#else
+#define TASK_MONITOR_AVAILABLE 0
+#endif
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define TASK_MONITOR_CPU 1
+#else
+#define TASK_MONITOR_CPU 0
+#endif
+
+// Load of one task over the last sampling interval
+struct TaskLoad {
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t priority;
+    eTaskState state;
+    int core;               // -1 when not pinned
+    float cpu;              // Percent of one core, 0 without TASK_MONITOR_CPU
+    uint32_t stackFree;     // Stack high-water mark in bytes
+};
+
+/*
+* FreeRTOS task runtime sampler
+*
+* Two uxTaskGetSystemState() snapshots live in static buffers and are
+* swapped on every sample, so taking a sample never touches the heap. The
+* CPU share of a task is the growth of its runtime counter between the
+* two snapshots. Without run time statistics every sample stands alone and
+* only priority, state and stack are filled in.
+*/
+class TaskMonitor {
+    public:
+        TaskMonitor();
+
+        /**
+         * Take a snapshot and compute the load since the previous one
+         * @return false until two snapshots exist (with TASK_MONITOR_CPU),
+         *         or if there are more than TASK_MONITOR_MAX_TASKS tasks
+         */
+        bool sample();
+
+        /**
+         * The last sample failed because there are more tasks than
+         * TASK_MONITOR_MAX_TASKS
+         */
+        inline bool overflowed() const { return _overflow; }
+
+        /**
+         * Forget the previous snapshot, the next sample starts a new interval
+         */
+        inline void reset() { _prevCount = 0; }
+
+        inline uint8_t getCount() const { return _count; }
+
+        /**
+         * Task by rank, busiest first (highest priority first without
+         * TASK_MONITOR_CPU)
+         */
+        inline const TaskLoad& getTask(uint8_t index) const { return _loads[_order[index]]; }
+
+        /**
+         * Busy share of a core: 100% minus its idle task
+         */
+        inline float getCoreBusy(uint8_t core) const { return core < portNUM_PROCESSORS ? _coreBusy[core] : 0; }
+
+        // Length of the last interval in runtime counter ticks (microseconds)
+        inline uint32_t getInterval() const { return _interval; }
+
+    private:
+        TaskStatus_t _snapshots[2][TASK_MONITOR_MAX_TASKS];
+        uint8_t _current;        // Snapshot buffer written last
+        UBaseType_t _prevCount;
+        uint32_t _prevTotal;
+        TaskLoad _loads[TASK_MONITOR_MAX_TASKS];
+        uint8_t _order[TASK_MONITOR_MAX_TASKS];
+        uint8_t _count;
+        float _coreBusy[portNUM_PROCESSORS];
+        uint32_t _interval;
+        bool _overflow;
+};
+
+// Global instance
+extern TaskMonitor Tasks;
+
+#endif
@@ -0,0 +1,338 @@
+#include "ymodem.h"
+
+#define SOH  0x01   // 128 byte block
+#define STX  0x02   // 1024 byte block
+#define EOT  0x04
+#define ACK  0x06
+#define NAK  0x15
+#define CAN  0x18
+#define SUB  0x1A   // Padding of the last block
+#define CRC  'C'    // Receiver asks for CRC16 mode
+
+// readBlock() results besides the block size
+#define BLOCK_TIMEOUT   -1
+#define BLOCK_EOT       -2
+#define BLOCK_CANCEL    -3
+#define BLOCK_BAD       -4
+
+// One frame: header (type, seq, ~seq), payload, CRC. Shared by both directions.
+static uint8_t s_frame[YMODEM_FRAME_SIZE];
+#define FRAME_DATA (_frame + 3)
+
+static const char* RESULT_NAMES[] = {
+    "OK",
+    "Timeout",
+    "Cancelled",
+    "Too many block errors",
+    "File error"
+};
+
+Ymodem::Ymodem(Stream& stream, uint8_t* frame)
+    : _stream(stream), _frame(frame ? frame : s_frame), _bytes(0), _startMs(0), _elapsedMs(0) {
+}
+
+const char* Ymodem::resultName(TransferResult result) {
+    return RESULT_NAMES[static_cast<int>(result)];
+}
+
+uint16_t Ymodem::crc16(const uint8_t* data, size_t size) {
+    // CRC-16/XMODEM, polynomial 0x1021
+    uint16_t crc = 0;
+    while (size--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+int Ymodem::readByte(uint32_t timeoutMs) {
+    uint32_t start = millis();
+    while (!_stream.available()) {
+        if (millis() - start >= timeoutMs) {
+            return -1;
+        }
+        delay(1);
+    }
+    return _stream.read();
+}
+
+void Ymodem::writeByte(uint8_t c) {
+    _stream.write(c);
+}
+
+void Ymodem::cancel() {
+    static const uint8_t CANCEL[] = { CAN, CAN, CAN, CAN, CAN };
+    _stream.write(CANCEL, sizeof(CANCEL));
+}
+
+void Ymodem::purge() {
+    // Drop the rest of a damaged frame
+    while (readByte(50) >= 0) {
+        ;
+    }
+}
+
+int Ymodem::readBlock(uint8_t& seq, uint32_t timeoutMs) {
+    size_t size;
+    uint32_t start = millis();
+    for (;;) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs) {
+            return BLOCK_TIMEOUT;
+        }
+        int c = readByte(timeoutMs - elapsed);
+        if (c == SOH) {
+            size = 128;
+            break;
+        }
+        if (c == STX) {
+            size = YMODEM_BLOCK_SIZE;
+            break;
+        }
+        if (c == EOT) {
+            return BLOCK_EOT;
+        }
+        if (c == CAN && readByte(1000) == CAN) {
+            return BLOCK_CANCEL;
+        }
+        // Anything else is line noise
+    }
+
+    _stream.setTimeout(YMODEM_BLOCK_TIMEOUT);
+    size_t frame = 2 + size + 2;
+    if (_stream.readBytes(_frame + 1, frame) != frame) {
+        return BLOCK_TIMEOUT;
+    }
+    if ((uint8_t)(_frame[1] ^ _frame[2]) != 0xFF) {
+        purge();
+        return BLOCK_BAD;
+    }
+    uint16_t crc = ((uint16_t)FRAME_DATA[size] << 8) | FRAME_DATA[size + 1];
+    if (crc16(FRAME_DATA, size) != crc) {
+        purge();
+        return BLOCK_BAD;
+    }
+    seq = _frame[1];
+    return size;
+}
+
+TransferResult Ymodem::receive(fs::FS& fs, const char* path) {
+    fs::File file;
+    bool started = false;
+    bool gotEot = false;
+    uint8_t expected = 0;
+    uint32_t fileSize = 0;   // 0 when the sender did not give one
+    uint8_t errors = 0;
+    uint32_t start = millis();
+    _bytes = 0;
+    _elapsedMs = 0;
+
+    for (;;) {
+        uint8_t seq = 0;
+        int result;
+        if (!started) {
+            // Ask for CRC mode once per second until the sender starts
+            if (millis() - start >= YMODEM_START_TIMEOUT) {
+                cancel();
+                return TransferResult::TIMEOUT;
+            }
+            writeByte(CRC);
+            result = readBlock(seq, 1000);
+            if (result == BLOCK_TIMEOUT) {
+                continue;
+            }
+        } else {
+            result = readBlock(seq, YMODEM_BLOCK_TIMEOUT);
+        }
+
+        if (result == BLOCK_CANCEL) {
+            if (file) file.close();
+            return TransferResult::CANCELLED;
+        }
+        if (result == BLOCK_TIMEOUT || result == BLOCK_BAD) {
+            if (++errors > YMODEM_RETRIES) {
+                cancel();
+                if (file) file.close();
+                return result == BLOCK_TIMEOUT ? TransferResult::TIMEOUT : TransferResult::BAD_BLOCK;
+            }
+            writeByte(NAK);
+            continue;
+        }
+        if (result == BLOCK_EOT) {
+            if (!gotEot) {
+                // NAK the first EOT so a corrupted data byte is not taken for it
+                gotEot = true;
+                writeByte(NAK);
+                continue;
+            }
+            writeByte(ACK);
+            file.close();
+            _elapsedMs = millis() - _startMs;
+            // Close the batch: the sender answers with an empty header block
+            writeByte(CRC);
+            if (readBlock(seq, YMODEM_BLOCK_TIMEOUT) >= 0) {
+                writeByte(ACK);
+            }
+            return TransferResult::OK;
+        }
+
+        if (!started) {
+            started = true;
+            _startMs = millis();
+        }
+        errors = 0;
+
+        if (!file) {
+            // Header block: "name\0size ..." or an empty name to end the batch
+            if (seq != 0) {
+                writeByte(NAK);
+                continue;
+            }
+            if (FRAME_DATA[0] == '\0') {
+                writeByte(ACK);
+                return TransferResult::CANCELLED;
+            }
+            // The size is optional and must be parsed within the block: a
+            // name filling it leaves no terminator to stop at
+            size_t field = strnlen(reinterpret_cast<const char*>(FRAME_DATA), result) + 1;
+            fileSize = 0;
+            for (size_t i = field; i < (size_t)result && FRAME_DATA[i] >= '0' && FRAME_DATA[i] <= '9'; i++) {
+                fileSize = fileSize * 10 + (FRAME_DATA[i] - '0');
+            }
+            file = fs.open(path, "w");
+            if (!file) {
+                cancel();
+                return TransferResult::FILE_ERROR;
+            }
+            expected = 1;
+            writeByte(ACK);
+            writeByte(CRC);
+            continue;
+        }
+
+        if (seq == (uint8_t)(expected - 1)) {
+            // Our ACK was lost, the sender repeated the block
+            writeByte(ACK);
+            continue;
+        }
+        if (seq != expected) {
+            cancel();
+            file.close();
+            return TransferResult::BAD_BLOCK;
+        }
+
+        size_t length = result;
+        if (fileSize != 0 && _bytes + length > fileSize) {
+            length = fileSize - _bytes;   // Strip the padding of the last block
+        }
+        if (file.write(FRAME_DATA, length) != length) {
+            cancel();
+            file.close();
+            return TransferResult::FILE_ERROR;
+        }
+        _bytes += length;
+        expected++;
+        gotEot = false;
+        writeByte(ACK);
+    }
+}
+
+TransferResult Ymodem::waitStart() {
+    uint32_t start = millis();
+    while (millis() - start < YMODEM_START_TIMEOUT) {
+        int c = readByte(1000);
+        if (c == CRC) {
+            return TransferResult::OK;
+        }
+        if (c == CAN && readByte(1000) == CAN) {
+            return TransferResult::CANCELLED;
+        }
+    }
+    return TransferResult::TIMEOUT;
+}
+
+TransferResult Ymodem::sendBlock(uint8_t seq, size_t size) {
+    _frame[0] = size == 128 ? SOH : STX;
+    _frame[1] = seq;
+    _frame[2] = ~seq;
+    uint16_t crc = crc16(FRAME_DATA, size);
+    FRAME_DATA[size] = crc >> 8;
+    FRAME_DATA[size + 1] = crc & 0xFF;
+
+    for (uint8_t attempt = 0; attempt <= YMODEM_RETRIES; attempt++) {
+        _stream.write(_frame, 3 + size + 2);
+        int c = readByte(YMODEM_BLOCK_TIMEOUT);
+        if (c == ACK) {
+            return TransferResult::OK;
+        }
+        if (c == CAN && readByte(1000) == CAN) {
+            return TransferResult::CANCELLED;
+        }
+        // NAK, noise or timeout: send again
+    }
+    cancel();
+    return TransferResult::BAD_BLOCK;
+}
+
+TransferResult Ymodem::send(fs::FS& fs, const char* path) {
+    fs::File file = fs.open(path, "r");
+    if (!file) {
+        return TransferResult::FILE_ERROR;
+    }
+    _bytes = 0;
+    _elapsedMs = 0;
+
+    TransferResult result = waitStart();
+    if (result != TransferResult::OK) {
+        file.close();
+        return result;
+    }
+    _startMs = millis();
+
+    // Header block: base name and size
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    memset(FRAME_DATA, 0, 128);
+    snprintf(reinterpret_cast<char*>(FRAME_DATA), 128 - 1, "%s%c%u", name, '\0', (unsigned)file.size());
+    result = sendBlock(0, 128);
+    if (result == TransferResult::OK) {
+        result = waitStart();
+    }
+
+    uint8_t seq = 1;
+    while (result == TransferResult::OK) {
+        size_t length = file.read(FRAME_DATA, YMODEM_BLOCK_SIZE);
+        if (length == 0) {
+            break;
+        }
+        size_t size = length <= 128 ? 128 : YMODEM_BLOCK_SIZE;
+        memset(FRAME_DATA + length, SUB, size - length);
+        result = sendBlock(seq++, size);
+        if (result == TransferResult::OK) {
+            _bytes += length;
+        }
+    }
+    file.close();
+    if (result != TransferResult::OK) {
+        return result;
+    }
+
+    // End of file, then an empty header block to end the batch
+    int c = -1;
+    for (uint8_t attempt = 0; attempt <= YMODEM_RETRIES && c != ACK; attempt++) {
+        writeByte(EOT);
+        c = readByte(YMODEM_BLOCK_TIMEOUT);
+    }
+    if (c != ACK) {
+        return TransferResult::TIMEOUT;
+    }
+    _elapsedMs = millis() - _startMs;
+    result = waitStart();
+    if (result != TransferResult::OK) {
+        return result;
+    }
+    memset(FRAME_DATA, 0, 128);
+    return sendBlock(0, 128);
+}
@@ -0,0 +1,83 @@
+#ifndef __YMODEM_H__
+#define __YMODEM_H__
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define YMODEM_BLOCK_SIZE      1024
+#define YMODEM_FRAME_SIZE      (3 + YMODEM_BLOCK_SIZE + 2)   // Header, payload, CRC
+#define YMODEM_RETRIES         10
+#define YMODEM_START_TIMEOUT   60000   // ms for the host to start the transfer
+#define YMODEM_BLOCK_TIMEOUT   3000    // ms per block once started
+
+enum class TransferResult {
+    OK = 0,
+    TIMEOUT,
+    CANCELLED,
+    BAD_BLOCK,      // Too many CRC or sequence errors
+    FILE_ERROR
+};
+
+/*
+* YMODEM (1K blocks, CRC16) file transfer over a CLI session stream
+*
+* Data is streamed between the session and the file system through one
+* fixed frame buffer, so the file size is bounded by the flash only.
+*/
+class Ymodem {
+    public:
+        /**
+         * @param stream Session stream
+         * @param frame YMODEM_FRAME_SIZE bytes, nullptr for the shared static
+         *              one (only one transfer at a time can use that)
+         */
+        Ymodem(Stream& stream, uint8_t* frame = nullptr);
+
+        /**
+         * Receive one file from the host and write it to path
+         * @param fs File system
+         * @param path Destination file (overwritten)
+         * @return Transfer result
+         */
+        TransferResult receive(fs::FS& fs, const char* path);
+
+        /**
+         * Send a file to the host
+         * @param fs File system
+         * @param path File to send
+         * @return Transfer result
+         */
+        TransferResult send(fs::FS& fs, const char* path);
+
+        /**
+         * Payload bytes moved by the last transfer
+         */
+        inline uint32_t getBytes() const { return _bytes; }
+
+        /**
+         * Duration of the last transfer from the first block, excluding the
+         * wait for the host to start
+         */
+        inline uint32_t getElapsed() const { return _elapsedMs; }
+
+        static const char* resultName(TransferResult result);
+
+    private:
+        Stream& _stream;
+        uint8_t* _frame;
+        uint32_t _bytes;
+        uint32_t _startMs;
+        uint32_t _elapsedMs;
+
+        int readByte(uint32_t timeoutMs);
+        void writeByte(uint8_t c);
+        void cancel();
+        void purge();
+        int readBlock(uint8_t& seq, uint32_t timeoutMs);
+        TransferResult sendBlock(uint8_t seq, size_t size);
+        TransferResult waitStart();
+
+        static uint16_t crc16(const uint8_t* data, size_t size);
+};
+
+#endif
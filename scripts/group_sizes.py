@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""Report the flash and RAM cost of each CLI command group.
+
+Builds the firmware once with every group and once with each group left
+out (-DCLI_GROUP_<NAME>=0), then prints the difference. Run from the
+project root:
+
+    python scripts/group_sizes.py [-e esp32doit-devkit-v1]
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+GROUPS = ["SYSTEM", "NETWORK", "PERIPHERALS", "DEBUG"]
+
+# "RAM:   [=         ]  13.9% (used 45560 bytes from 327680 bytes)"
+SIZE_RE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes", re.MULTILINE)
+
+
+def build(env, flags):
+    """Build with extra flags and return (flash, ram) in bytes."""
+    environ = dict(os.environ)
+    extra = environ.get("PLATFORMIO_BUILD_FLAGS", "")
+    environ["PLATFORMIO_BUILD_FLAGS"] = " ".join([extra] + flags).strip()
+    result = subprocess.run(["pio", "run", "-e", env], env=environ,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        sys.stdout.write(result.stdout)
+        sys.exit("Build failed with flags: %s" % " ".join(flags))
+    sizes = dict((name, int(used)) for name, used in SIZE_RE.findall(result.stdout))
+    return sizes["Flash"], sizes["RAM"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-e", "--environment", default="esp32doit-devkit-v1")
+    args = parser.parse_args()
+
+    flash, ram = build(args.environment, [])
+    print("%-12s %10s %10s" % ("Group", "Flash", "RAM"))
+    print("%-12s %10d %10d" % ("(all)", flash, ram))
+
+    for group in GROUPS:
+        without_flash, without_ram = build(args.environment, ["-DCLI_GROUP_%s=0" % group])
+        print("%-12s %+10d %+10d" % (group.lower(), flash - without_flash, ram - without_ram))
+
+
+if __name__ == "__main__":
+    main()
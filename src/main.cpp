@@ -4,6 +4,15 @@
 #include <TelnetStream.h>
 #include "cli.h"
 #include "cli_command.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "wifi_store.h"
+#include "cli_log.h"
+#include "sensor_logger.h"
+#include "idle.h"
+#include "system_state.h"
+#include "heap_map.h"
 
 //TODO
 /**
@@ -15,26 +24,41 @@
 const long gmtOffset_sec = 25200;//3600 * Time
 const int daylightOffset_sec = 3600;
 
-// WiFi credentials
+// WiFi credentials, used until others are saved with 'wifi save'
 const char ssid[] = "WIFI_SSID";
 const char pass[] = "WIFI_PASS";
 
 
 
+// Metrics
+static const float LOOP_US_BUCKETS[] = {10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000};
+Histogram loopDuration("loop_duration_us", "Duration of one loop() iteration",
+                       LOOP_US_BUCKETS, sizeof(LOOP_US_BUCKETS) / sizeof(LOOP_US_BUCKETS[0]));
+Gauge heapFree("heap_free_bytes", "Free heap");
+Gauge wifiRssi("wifi_rssi_dbm", "RSSI of the current access point");
+Gauge adcValue("adc_value", "Mean ADC reading on A0 over the last window");
+Counter loopCount("loop_iterations_total", "loop() iterations");
+
 // Function prototypes
 void setupWiFi();
 void setupTime();
-void logSensorData();
+void logSensorData(const SensorChannel& channel);
 void restartESP();
+void updateMetrics();
 
 void setup() {
   // Start CLI (which initializes Serial)
   CLI.begin(115200);
   CLI.println("ESP32 CLI Demo");
+
+  // loop() blocks between events instead of spinning
+#ifdef CLI_LIGHT_SLEEP
+  Idle.begin(true);
+#else
+  Idle.begin(false);
+#endif
   
-  // Initialize CommandManager
-  // debug message
-  // CLI.println("Initializing CommandManager...");
+  CLI_LOGD(MAIN, "Initializing CommandManager");
 
   
 
@@ -56,53 +80,96 @@ void setup() {
   //   2, 2
   // ));
   
+  // Follow Wi-Fi events from the first connection on
+  State.begin();
+
   // Setup network
-  //debug message 
-  // CLI.println("Setting up WiFi...");
+  CLI_LOGD(MAIN, "Setting up WiFi");
   setupWiFi();
 
-  //debug message
-  // CLI.println("Setting up time...");
+  // Accept telnet clients as soon as the network is up
+  TelnetStream.begin();
+  CLI_LOGI(MAIN, "Telnet ready %lu ms after reset", millis());
+
+  CLI_LOGD(MAIN, "Setting up time");
   setupTime();
   
-  // Initialize telnet
   Commands.begin();
-  TelnetStream.begin();
+
+#ifdef CLI_TASK_CORE
+#if CLI_TASK_CORE == CONFIG_ARDUINO_RUNNING_CORE
+#error "CLI_TASK_CORE must differ from the core loop() runs on"
+#endif
+  // Parse and dispatch commands on the other core, loop() only runs
+  // the commands that touch application state
+  if (!CLI.startTask(CLI_TASK_CORE)) {
+    CLI_LOGE(CLI, "CLI task not started, commands run in loop()");
+  }
+#endif
+
+  MetricsHttp.begin();
+
+  // Sample A0 every 10 ms and log a summary every 5 s ('sensor' configures).
+  // With light sleep every sample is a wake-up: sample no faster than the
+  // sockets are polled, over a longer window
+  Sensors.onWindow(logSensorData);
+#ifdef CLI_LIGHT_SLEEP
+  Sensors.addChannel("adc", A0, IDLE_SLEEP_NET_POLL_MS, 30000);
+#else
+  Sensors.addChannel("adc", A0, 10, 5000);
+#endif
+  Sched.addTask(1000, updateMetrics);
+
+  // Largest free block trend for 'memory map'
+  HeapMaps.sampleTrend();
+  Sched.addTask(HEAP_TREND_INTERVAL_MS, []() { HeapMaps.sampleTrend(); });
   
 
 }
 
 void loop() {
+  // Sleep until input arrives or the next task is due
+  Idle.wait(CLI.hasPendingInput() ? 0 : Sched.timeToNext());
+
+  unsigned long loopStart = micros();
+  AllocTrace.loopBegin();
+
   // Process CLI input
   CLI.update();
   
-  // Log sensor data periodically
-  static unsigned long nextLog = 0;
-  if (millis() - nextLog > 5000) {
-    nextLog = millis();
-    logSensorData();
-  }
+  // Run periodic tasks (sensor log, watch...)
+  Sched.update();
+
+  // Serve Prometheus scrapes
+  MetricsHttp.update();
+
+  AllocTrace.loopEnd();
+  loopCount.inc();
+  loopDuration.observe(micros() - loopStart);
 }
 
 void setupWiFi() {
-  CLI.print("Connecting to WiFi: ");
-  CLI.println(ssid);
-  
-  WiFi.begin(ssid, pass);
-  while (WiFi.waitForConnectResult() != WL_CONNECTED) {
-    CLI.println("Connection failed, retrying...");
-    WiFi.begin(ssid, pass);
-    delay(100);
+  if (WifiConfig.load()) {
+    CLI_LOGI(WIFI, "Connecting to saved WiFi: %s", WifiConfig.getSSID());
+    WifiConfig.connect();
+  }
+
+  while (WiFi.status() != WL_CONNECTED) {
+    CLI_LOGI(WIFI, "Connecting to WiFi: %s", ssid);
+    if (!WifiConfig.connect(ssid, pass)) {
+      CLI_LOGW(WIFI, "Connection failed, retrying");
+      delay(100);
+    }
   }
   
-  CLI.println("WiFi connected!");
-  CLI.print("IP address: ");
-  CLI.println(WiFi.localIP().toString());
+  CLI_LOGI(WIFI, "WiFi connected in %lu ms%s", (unsigned long)WifiConfig.getConnectTime(),
+           WifiConfig.wasFastConnect() ? " (fast)" : "");
+  CLI_LOGI(WIFI, "IP address: %s", WiFi.localIP().toString().c_str());
   CLI.println("Connect with Telnet client to this IP");
 }
 
 void setupTime() {
-  CLI.println("Synchronizing time...");
+  CLI_LOGD(MAIN, "Synchronizing time");
   configTime(gmtOffset_sec, daylightOffset_sec, "pool.ntp.org");
   
   time_t now = time(nullptr);
@@ -112,27 +179,39 @@ void setupTime() {
   }
   setTime(now);
   
-  CLI.println("Time synchronized");
+  CLI_LOGI(MAIN, "Time synchronized");
 }
 
-void logSensorData() {
-  char timeStr[20];
-  sprintf(timeStr, "%02d-%02d-%02d %02d:%02d:%02d", 
-          year(), month(), day(), hour(), minute(), second());
-  
-  int adcValue = analogRead(A0);
-  
-  // Only log if in BOTH interface mode or if client is connected in TELNET mode
-  if (CLI.getCurrentInterface() == OutputInterface::BOTH || 
-      (CLI.getCurrentInterface() == OutputInterface::telnet && CLI.isClientConnected())) {
-    CLI.print(timeStr);
-    CLI.print(" ADC: ");
-    CLI.println(String(adcValue));
+void logSensorData(const SensorChannel& channel) {
+  const WindowStats& w = channel.last;
+  if (channel.pin == A0) {
+    adcValue.set(w.mean);
+  }
+
+  // Nothing to format if no session subscribed to the log
+  if (!CLI.hasSubscribers(Topic::SENSOR_LOG)) {
+    return;
   }
+
+  SystemSnapshot state;
+  State.read(state);
+  char line[160];
+  int len = snprintf(line, sizeof(line),
+                     "%s %s n=%u min=%.0f max=%.0f mean=%.1f sd=%.1f p50=%.0f p90=%.0f p99=%.0f\r\n",
+                     state.timestamp, channel.name,
+                     (unsigned)w.count, w.min, w.max, w.mean, w.stddev, w.p50, w.p90, w.p99);
+  CLI.broadcast(Topic::SENSOR_LOG, line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
 }
 
 
 
+void updateMetrics() {
+  SystemSnapshot state;
+  State.read(state);
+  heapFree.set(state.heapFree);
+  wifiRssi.set(state.connected ? state.rssi : 0);
+}
+
 void restartESP() {
   CLI.println("Restarting ESP32...");
   delay(500);
@@ -0,0 +1,152 @@
+#ifndef __NATIVE_ARDUINO_H__
+#define __NATIVE_ARDUINO_H__
+
+/*
+* Host stand-in for the parts of the Arduino core used by the libraries
+* under test (env:native). Header only: every test links its own copy.
+*
+* String allocates through malloc/realloc/free like the real WString, so
+* the allocation counters see the same churn as on the device.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+typedef bool boolean;
+
+#define IRAM_ATTR
+
+inline unsigned long millis() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+class String {
+    public:
+        String(const char* str = "") : _buf(nullptr), _len(0) { assign(str, str ? strlen(str) : 0); }
+        String(const String& other) : _buf(nullptr), _len(0) { assign(other._buf, other._len); }
+        String(String&& other) : _buf(other._buf), _len(other._len) { other._buf = nullptr; other._len = 0; }
+        explicit String(long value) : _buf(nullptr), _len(0) {
+            char num[24];
+            assign(num, snprintf(num, sizeof(num), "%ld", value));
+        }
+        ~String() { free(_buf); }
+
+        String& operator=(const String& other) {
+            if (this != &other) {
+                assign(other._buf, other._len);
+            }
+            return *this;
+        }
+        String& operator=(const char* str) { assign(str, str ? strlen(str) : 0); return *this; }
+
+        bool concat(const char* str, unsigned int len) {
+            char* buf = static_cast<char*>(realloc(_buf, _len + len + 1));
+            if (!buf) {
+                return false;
+            }
+            memcpy(buf + _len, str, len);
+            _len += len;
+            buf[_len] = '\0';
+            _buf = buf;
+            return true;
+        }
+        String& operator+=(const char* str) { concat(str, strlen(str)); return *this; }
+        String& operator+=(const String& other) { concat(other.c_str(), other._len); return *this; }
+        String& operator+=(char c) { concat(&c, 1); return *this; }
+
+        inline const char* c_str() const { return _buf ? _buf : ""; }
+        inline unsigned int length() const { return _len; }
+        inline bool operator==(const String& other) const { return strcmp(c_str(), other.c_str()) == 0; }
+        inline bool equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+        inline long toInt() const { return atol(c_str()); }
+
+    private:
+        char* _buf;
+        unsigned int _len;
+
+        void assign(const char* str, size_t len) {
+            free(_buf);
+            _buf = nullptr;
+            _len = 0;
+            concat(str ? str : "", len);
+        }
+};
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size) {
+            size_t n = 0;
+            while (size-- && write(*buffer++)) {
+                n++;
+            }
+            return n;
+        }
+        size_t write(const char* str) { return write(reinterpret_cast<const uint8_t*>(str), strlen(str)); }
+        size_t print(const char* str) { return write(str); }
+        size_t print(const String& str) { return write(str.c_str()); }
+        size_t println(const char* str = "") { return print(str) + write("\r\n"); }
+        virtual void flush() {}
+};
+
+class Stream : public Print {
+    public:
+        Stream() : _timeout(1000) {}
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+        size_t readBytes(uint8_t* buffer, size_t length) {
+            size_t count = 0;
+            while (count < length) {
+                int c = timedRead();
+                if (c < 0) {
+                    break;
+                }
+                buffer[count++] = (uint8_t)c;
+            }
+            return count;
+        }
+
+    protected:
+        unsigned long _timeout;
+
+        int timedRead() {
+            unsigned long start = millis();
+            do {
+                if (available()) {
+                    return read();
+                }
+                yield();
+            } while (millis() - start < _timeout);
+            return -1;
+        }
+};
+
+#endif
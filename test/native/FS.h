@@ -0,0 +1,80 @@
+#ifndef __NATIVE_FS_H__
+#define __NATIVE_FS_H__
+
+/*
+* Host stand-in for the Arduino file system API (env:native)
+*
+* An in-memory file system: fs::FS keeps whole files as strings, fs::File
+* reads and writes them in place. Not thread safe, give each thread its
+* own FS.
+*/
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+class File {
+    public:
+        File() : _pos(0) {}
+        File(std::shared_ptr<std::string> data, bool append) : _data(data), _pos(append ? data->size() : 0) {}
+
+        size_t write(const uint8_t* buffer, size_t size) {
+            if (!_data) {
+                return 0;
+            }
+            _data->replace(_pos, size, reinterpret_cast<const char*>(buffer), size);
+            _pos += size;
+            return size;
+        }
+
+        size_t read(uint8_t* buffer, size_t size) {
+            if (!_data || _pos >= _data->size()) {
+                return 0;
+            }
+            size_t n = _data->copy(reinterpret_cast<char*>(buffer), size, _pos);
+            _pos += n;
+            return n;
+        }
+
+        size_t size() const { return _data ? _data->size() : 0; }
+        void close() { _data.reset(); }
+        operator bool() const { return _data != nullptr; }
+
+    private:
+        std::shared_ptr<std::string> _data;
+        size_t _pos;
+};
+
+class FS {
+    public:
+        File open(const char* path, const char* mode = "r") {
+            auto file = _files.find(path);
+            if (mode[0] == 'r') {
+                return file == _files.end() ? File() : File(file->second, false);
+            }
+            if (file == _files.end() || mode[0] == 'w') {
+                _files[path] = std::make_shared<std::string>();
+            }
+            return File(_files[path], mode[0] == 'a');
+        }
+
+        bool exists(const char* path) { return _files.count(path) > 0; }
+
+        // Test access to the contents
+        std::string& contents(const char* path) {
+            if (!exists(path)) {
+                _files[path] = std::make_shared<std::string>();
+            }
+            return *_files[path];
+        }
+
+    private:
+        std::map<std::string, std::shared_ptr<std::string>> _files;
+};
+
+}
+
+#endif
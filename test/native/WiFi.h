@@ -0,0 +1,81 @@
+#ifndef __NATIVE_WIFI_H__
+#define __NATIVE_WIFI_H__
+
+/*
+* Host stand-in for WiFiServer/WiFiClient (env:native)
+*
+* Tests play the remote peer: they queue a NativeConnection, which the
+* server hands out on its next available(), feed request bytes into it and
+* read back what was written.
+*/
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+#include <string>
+
+struct NativeConnection {
+    std::string received;   // Sent by the peer, read by the device
+    size_t readPos = 0;
+    std::string sent;       // Written by the device
+    bool open = true;       // Until either side closes
+    bool reset = false;     // Device closed with unread data: lwIP sends RST
+};
+
+inline std::deque<std::shared_ptr<NativeConnection>> s_nativeAccept;
+
+inline std::shared_ptr<NativeConnection> nativeConnect(const char* request = "") {
+    auto conn = std::make_shared<NativeConnection>();
+    conn->received = request;
+    s_nativeAccept.push_back(conn);
+    return conn;
+}
+
+class WiFiClient : public Stream {
+    public:
+        WiFiClient(std::shared_ptr<NativeConnection> conn = nullptr) : _conn(conn) {}
+
+        int available() override { return _conn ? _conn->received.size() - _conn->readPos : 0; }
+        int read() override { return available() ? (uint8_t)_conn->received[_conn->readPos++] : -1; }
+        int peek() override { return available() ? (uint8_t)_conn->received[_conn->readPos] : -1; }
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t* buffer, size_t size) override {
+            if (!connected()) {
+                return 0;
+            }
+            _conn->sent.append(reinterpret_cast<const char*>(buffer), size);
+            return size;
+        }
+
+        uint8_t connected() { return _conn && _conn->open; }
+        void stop() {
+            if (_conn) {
+                _conn->reset = available() > 0;
+                _conn->open = false;
+                _conn.reset();
+            }
+        }
+        operator bool() { return connected(); }
+
+    private:
+        std::shared_ptr<NativeConnection> _conn;
+};
+
+class WiFiServer {
+    public:
+        WiFiServer(uint16_t port) {}
+        void begin() {}
+        void setNoDelay(bool noDelay) {}
+
+        WiFiClient available() {
+            if (s_nativeAccept.empty()) {
+                return WiFiClient();
+            }
+            WiFiClient client(s_nativeAccept.front());
+            s_nativeAccept.pop_front();
+            return client;
+        }
+};
+
+#endif
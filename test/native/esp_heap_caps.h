@@ -0,0 +1,98 @@
+#ifndef __NATIVE_ESP_HEAP_CAPS_H__
+#define __NATIVE_ESP_HEAP_CAPS_H__
+
+/*
+* Host stand-in for the heap capabilities API (env:native)
+*
+* A scripted heap: tests list the free block sizes with nativeHeapSetFree(),
+* allocations take the smallest block that fits and freeing gives the block
+* back whole. The capability bits are ignored, there is a single heap.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <map>
+
+#define MALLOC_CAP_EXEC      (1 << 0)
+#define MALLOC_CAP_32BIT     (1 << 1)
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_SPIRAM    (1 << 10)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+#define MALLOC_CAP_DEFAULT   (1 << 12)
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+inline std::vector<size_t> s_nativeHeapFree;
+inline std::map<void*, size_t> s_nativeHeapUsed;
+inline uintptr_t s_nativeHeapNext = 0x1000;
+
+inline void nativeHeapSetFree(std::initializer_list<size_t> blocks) {
+    s_nativeHeapFree.assign(blocks);
+    s_nativeHeapUsed.clear();
+}
+
+inline size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    size_t largest = 0;
+    for (size_t size : s_nativeHeapFree) {
+        largest = size > largest ? size : largest;
+    }
+    return largest;
+}
+
+inline size_t heap_caps_get_free_size(uint32_t caps) {
+    size_t total = 0;
+    for (size_t size : s_nativeHeapFree) {
+        total += size;
+    }
+    return total;
+}
+
+inline void heap_caps_get_info(multi_heap_info_t* info, uint32_t caps) {
+    *info = {};
+    info->total_free_bytes = heap_caps_get_free_size(caps);
+    info->largest_free_block = heap_caps_get_largest_free_block(caps);
+    info->free_blocks = s_nativeHeapFree.size();
+    for (const auto& used : s_nativeHeapUsed) {
+        info->total_allocated_bytes += used.second;
+        info->allocated_blocks++;
+    }
+    info->total_blocks = info->free_blocks + info->allocated_blocks;
+}
+
+inline void* heap_caps_malloc(size_t size, uint32_t caps) {
+    size_t best = s_nativeHeapFree.size();
+    for (size_t i = 0; i < s_nativeHeapFree.size(); i++) {
+        if (s_nativeHeapFree[i] >= size && (best == s_nativeHeapFree.size() || s_nativeHeapFree[i] < s_nativeHeapFree[best])) {
+            best = i;
+        }
+    }
+    if (size == 0 || best == s_nativeHeapFree.size()) {
+        return nullptr;
+    }
+    size_t block = s_nativeHeapFree[best];
+    s_nativeHeapFree.erase(s_nativeHeapFree.begin() + best);
+    void* ptr = reinterpret_cast<void*>(s_nativeHeapNext);
+    s_nativeHeapNext += 0x1000;
+    s_nativeHeapUsed[ptr] = block;
+    return ptr;
+}
+
+inline void heap_caps_free(void* ptr) {
+    auto used = s_nativeHeapUsed.find(ptr);
+    if (used != s_nativeHeapUsed.end()) {
+        s_nativeHeapFree.push_back(used->second);
+        s_nativeHeapUsed.erase(used);
+    }
+}
+
+#endif
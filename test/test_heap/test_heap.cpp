@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <alloc_trace.h>
+#include <heap_map.h>
+#include <stats.h>
+
+void setUp() {}
+void tearDown() {}
+
+// The wrappers must see String churn, or the other checks prove nothing
+void test_trace_counts_string_growth() {
+    AllocCounters before = AllocTrace.snapshot();
+    String text("status");
+    text += " --json";
+    AllocCounters delta = AllocTrace.snapshot() - before;
+    TEST_ASSERT_EQUAL(2, delta.allocs);
+}
+
+void test_stats_do_not_allocate() {
+    RunningStats stats;
+    P2Quantile p90(0.9f);
+    AllocCounters before = AllocTrace.snapshot();
+    for (int i = 0; i < 1000; i++) {
+        stats.add(i % 97);
+        p90.add(i % 97);
+    }
+    TEST_ASSERT_EQUAL(0, (AllocTrace.snapshot() - before).allocs);
+}
+
+void test_bucket_bounds() {
+    TEST_ASSERT_EQUAL(0, HeapMap::bucketOf(16));
+    TEST_ASSERT_EQUAL(0, HeapMap::bucketOf(63));
+    TEST_ASSERT_EQUAL(1, HeapMap::bucketOf(64));
+    TEST_ASSERT_EQUAL(5, HeapMap::bucketOf(65535));
+    TEST_ASSERT_EQUAL(6, HeapMap::bucketOf(65536));
+    TEST_ASSERT_EQUAL(6, HeapMap::bucketOf(4000000));
+    TEST_ASSERT_EQUAL(1024, HeapMap::bucketMin(3));
+}
+
+void test_probe_histogram() {
+    nativeHeapSetFree({ 8, 40, 100, 300, 5000, 70000 });
+    FreeBlockHistogram hist;
+    TEST_ASSERT_TRUE(HeapMaps.probe(MALLOC_CAP_8BIT, hist, 0));
+    TEST_ASSERT_EQUAL(1, hist.buckets[0]);
+    TEST_ASSERT_EQUAL(1, hist.buckets[1]);
+    TEST_ASSERT_EQUAL(1, hist.buckets[2]);
+    TEST_ASSERT_EQUAL(0, hist.buckets[3]);
+    TEST_ASSERT_EQUAL(1, hist.buckets[4]);
+    TEST_ASSERT_EQUAL(0, hist.buckets[5]);
+    TEST_ASSERT_EQUAL(1, hist.buckets[6]);
+    TEST_ASSERT_EQUAL(5, hist.probed);
+    TEST_ASSERT_EQUAL(75440, hist.probedBytes);
+    TEST_ASSERT_EQUAL(1, hist.rest);
+    TEST_ASSERT_EQUAL(8, hist.restBytes);
+
+    // Every probed block is given back
+    TEST_ASSERT_EQUAL(75448, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    TEST_ASSERT_EQUAL(6, s_nativeHeapFree.size());
+}
+
+void test_probe_limit() {
+    nativeHeapSetFree({});
+    for (int i = 0; i < HEAP_MAP_MAX_PROBES + 8; i++) {
+        s_nativeHeapFree.push_back(100);
+    }
+    FreeBlockHistogram hist;
+    TEST_ASSERT_TRUE(HeapMaps.probe(MALLOC_CAP_8BIT, hist, 0));
+    TEST_ASSERT_EQUAL(HEAP_MAP_MAX_PROBES, hist.probed);
+    TEST_ASSERT_EQUAL(8, hist.rest);
+    TEST_ASSERT_EQUAL(800, hist.restBytes);
+}
+
+// The last HEAP_MAP_RESERVE bytes are never taken, whatever the block sizes
+void test_probe_keeps_reserve() {
+    nativeHeapSetFree({ 40000, 10000, 8000, 4000 });
+    FreeBlockHistogram hist;
+    TEST_ASSERT_TRUE(HeapMaps.probe(MALLOC_CAP_8BIT, hist));
+    TEST_ASSERT_TRUE(hist.reserveHit);
+    TEST_ASSERT_EQUAL(1, hist.probed);
+    TEST_ASSERT_EQUAL(40000, hist.probedBytes);
+    TEST_ASSERT_EQUAL(3, hist.rest);
+    TEST_ASSERT_EQUAL(62000, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+void test_probe_empty_heap() {
+    nativeHeapSetFree({});
+    FreeBlockHistogram hist;
+    TEST_ASSERT_FALSE(HeapMaps.probe(MALLOC_CAP_8BIT, hist));
+}
+
+void test_trend_keeps_latest_oldest_first() {
+    HeapMap map;
+    for (size_t i = 1; i <= HEAP_TREND_SIZE + 3; i++) {
+        nativeHeapSetFree({ i * 1000 });
+        map.sampleTrend();
+    }
+    TEST_ASSERT_EQUAL(HEAP_TREND_SIZE, map.getTrendCount());
+    TEST_ASSERT_EQUAL(4000, map.getTrend(0));
+    TEST_ASSERT_EQUAL((HEAP_TREND_SIZE + 3) * 1000, map.getTrend(HEAP_TREND_SIZE - 1));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_counts_string_growth);
+    RUN_TEST(test_stats_do_not_allocate);
+    RUN_TEST(test_bucket_bounds);
+    RUN_TEST(test_probe_histogram);
+    RUN_TEST(test_probe_limit);
+    RUN_TEST(test_probe_keeps_reserve);
+    RUN_TEST(test_probe_empty_heap);
+    RUN_TEST(test_trend_keeps_latest_oldest_first);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <string>
+#include <unity.h>
+#include <alloc_trace.h>
+#include <metrics.h>
+#include <metrics_server.h>
+
+static const float BUCKETS[] = { 10, 100, 1000 };
+Counter requests("test_requests_total", "Requests handled");
+Gauge heap("test_heap_bytes", "Free heap");
+Histogram latency("test_latency_us", "Request latency", BUCKETS, 3);
+// Metrics register themselves for good, so they all live at file scope
+static const float LOOP_BUCKETS[] = { 1 };
+Histogram loopTime("test_loop_us", "Loop duration", LOOP_BUCKETS, 1);
+
+// Collects the rendered text
+class TextPrint : public Print {
+    public:
+        std::string text;
+        size_t write(uint8_t c) override { text += (char)c; return 1; }
+        size_t write(const uint8_t* data, size_t size) override {
+            text.append(reinterpret_cast<const char*>(data), size);
+            return size;
+        }
+};
+
+static bool contains(const std::string& text, const char* line) {
+    return text.find(line) != std::string::npos;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_render_prometheus_text() {
+    requests.inc(3);
+    heap.set(123456);
+    latency.observe(5);
+    latency.observe(50);
+    latency.observe(50);
+    latency.observe(5000);
+
+    TextPrint out;
+    Metrics.render(out);
+    TEST_ASSERT_TRUE(contains(out.text, "# HELP test_requests_total Requests handled\n# TYPE test_requests_total counter\ntest_requests_total 3\n"));
+    TEST_ASSERT_TRUE(contains(out.text, "# TYPE test_heap_bytes gauge\ntest_heap_bytes 123456\n"));
+    TEST_ASSERT_TRUE(contains(out.text,
+        "# TYPE test_latency_us histogram\n"
+        "test_latency_us_bucket{le=\"10\"} 1\n"
+        "test_latency_us_bucket{le=\"100\"} 3\n"
+        "test_latency_us_bucket{le=\"1000\"} 3\n"
+        "test_latency_us_bucket{le=\"+Inf\"} 4\n"
+        "test_latency_us_sum 5105\n"
+        "test_latency_us_count 4\n"));
+}
+
+void test_render_does_not_allocate() {
+    TextPrint out;
+    out.text.reserve(4096);
+    AllocCounters before = AllocTrace.snapshot();
+    Metrics.render(out);
+    TEST_ASSERT_EQUAL(0, (AllocTrace.snapshot() - before).allocs);
+}
+
+// Small samples must still count after minutes of loop() timings
+void test_histogram_sum_keeps_growing() {
+    loopTime.observe(2e8f);
+    for (int i = 0; i < 1000; i++) {
+        loopTime.observe(10);
+    }
+    TextPrint out;
+    loopTime.render(out);
+    TEST_ASSERT_TRUE(contains(out.text, "test_loop_us_sum 200010000\n"));
+}
+
+void test_scrape() {
+    MetricsServer server;
+    server.begin();
+    auto conn = nativeConnect("GET /metrics HTTP/1.1\r\nHost: device\r\n\r\n");
+    server.update();
+
+    TEST_ASSERT_FALSE(conn->open);
+    TEST_ASSERT_FALSE(conn->reset);
+    TEST_ASSERT_EQUAL(1, server.getRequests());
+    TEST_ASSERT_EQUAL(0, conn->sent.find("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"));
+    TEST_ASSERT_TRUE(contains(conn->sent, "\r\n\r\n# HELP test_requests_total"));
+    TEST_ASSERT_TRUE(contains(conn->sent, "test_latency_us_count "));
+}
+
+void test_scrape_request_split_across_updates() {
+    MetricsServer server;
+    server.begin();
+    auto conn = nativeConnect("GET /met");
+    server.update();
+    TEST_ASSERT_TRUE(conn->open);
+    TEST_ASSERT_EQUAL(0, conn->sent.size());
+
+    // Answered only once the headers are complete
+    conn->received += "rics HTTP/1.1\r\nHost: device\r\n";
+    server.update();
+    TEST_ASSERT_TRUE(conn->open);
+    TEST_ASSERT_EQUAL(0, conn->sent.size());
+
+    conn->received += "Accept: text/plain\r\n\r\n";
+    server.update();
+    TEST_ASSERT_FALSE(conn->open);
+    TEST_ASSERT_FALSE(conn->reset);
+    TEST_ASSERT_EQUAL(1, server.getRequests());
+    TEST_ASSERT_TRUE(contains(conn->sent, "test_heap_bytes "));
+}
+
+// Bytes after the headers are read before closing, or the close is a reset
+void test_close_drains_request() {
+    MetricsServer server;
+    server.begin();
+    auto conn = nativeConnect("GET /metrics?name[]=x HTTP/1.1\r\n\r\nextra");
+    server.update();
+    TEST_ASSERT_FALSE(conn->open);
+    TEST_ASSERT_FALSE(conn->reset);
+    TEST_ASSERT_EQUAL(0, conn->sent.find("HTTP/1.0 200 OK\r\n"));
+}
+
+void test_unknown_path() {
+    MetricsServer server;
+    server.begin();
+    auto conn = nativeConnect("GET / HTTP/1.1\r\n\r\n");
+    server.update();
+    TEST_ASSERT_EQUAL(0, conn->sent.find("HTTP/1.0 404 Not Found\r\n"));
+
+    conn = nativeConnect("GET /metricsfoo HTTP/1.1\r\n\r\n");
+    server.update();
+    TEST_ASSERT_EQUAL(0, conn->sent.find("HTTP/1.0 404 Not Found\r\n"));
+    TEST_ASSERT_EQUAL(0, server.getRequests());
+}
+
+// An idle scraper must not hold up the caller, only time out
+void test_idle_client_does_not_block() {
+    MetricsServer server;
+    server.begin();
+    auto conn = nativeConnect();
+    unsigned long start = millis();
+    server.update();
+    TEST_ASSERT_TRUE(millis() - start < 20);
+    TEST_ASSERT_TRUE(conn->open);
+
+    delay(METRICS_REQUEST_TIMEOUT + 10);
+    server.update();
+    TEST_ASSERT_FALSE(conn->open);
+    TEST_ASSERT_EQUAL(0, conn->sent.size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_render_prometheus_text);
+    RUN_TEST(test_render_does_not_allocate);
+    RUN_TEST(test_histogram_sum_keeps_growing);
+    RUN_TEST(test_scrape);
+    RUN_TEST(test_scrape_request_split_across_updates);
+    RUN_TEST(test_close_drains_request);
+    RUN_TEST(test_unknown_path);
+    RUN_TEST(test_idle_client_does_not_block);
+    return UNITY_END();
+}
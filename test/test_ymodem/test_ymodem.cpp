@@ -0,0 +1,255 @@
+#include <Arduino.h>
+#include <FS.h>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unity.h>
+#include <ymodem.h>
+
+/*
+* In-memory serial link: two ends, each reading what the other wrote. The
+* sender to receiver direction can damage bytes by their stream offset.
+*/
+struct Link {
+    std::mutex lock;
+    std::deque<uint8_t> toReceiver;
+    std::deque<uint8_t> toSender;
+    size_t sent = 0;
+    std::function<bool(size_t offset)> corrupt;
+};
+
+class LinkEnd : public Stream {
+    public:
+        LinkEnd(Link& link, bool sender) : _link(link), _sender(sender) {}
+
+        int available() override {
+            std::lock_guard<std::mutex> guard(_link.lock);
+            return in().size();
+        }
+        int read() override {
+            std::lock_guard<std::mutex> guard(_link.lock);
+            if (in().empty()) {
+                return -1;
+            }
+            uint8_t c = in().front();
+            in().pop_front();
+            return c;
+        }
+        int peek() override {
+            std::lock_guard<std::mutex> guard(_link.lock);
+            return in().empty() ? -1 : in().front();
+        }
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t* data, size_t size) override {
+            std::lock_guard<std::mutex> guard(_link.lock);
+            for (size_t i = 0; i < size; i++) {
+                uint8_t c = data[i];
+                if (_sender && _link.corrupt && _link.corrupt(_link.sent)) {
+                    c ^= 0x5A;
+                }
+                if (_sender) {
+                    _link.sent++;
+                }
+                out().push_back(c);
+            }
+            return size;
+        }
+
+    private:
+        Link& _link;
+        bool _sender;
+
+        std::deque<uint8_t>& in() { return _sender ? _link.toSender : _link.toReceiver; }
+        std::deque<uint8_t>& out() { return _sender ? _link.toReceiver : _link.toSender; }
+};
+
+static std::string pattern(size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (char)((i * 31 + i / 251) & 0xFF);
+    }
+    return data;
+}
+
+struct RoundTrip {
+    TransferResult sent;
+    TransferResult received;
+    uint32_t sentBytes;
+    uint32_t receivedBytes;
+    std::string output;
+};
+
+static RoundTrip roundTrip(const std::string& input, std::function<bool(size_t)> corrupt = nullptr) {
+    Link link;
+    link.corrupt = corrupt;
+    LinkEnd senderEnd(link, true);
+    LinkEnd receiverEnd(link, false);
+    fs::FS source;
+    fs::FS target;
+    source.contents("/cal/table.csv") = input;
+
+    // Separate frame buffers, both sides run at once
+    static uint8_t senderFrame[YMODEM_FRAME_SIZE];
+    static uint8_t receiverFrame[YMODEM_FRAME_SIZE];
+    Ymodem sender(senderEnd, senderFrame);
+    Ymodem receiver(receiverEnd, receiverFrame);
+
+    RoundTrip result;
+    std::thread host([&]() { result.sent = sender.send(source, "/cal/table.csv"); });
+    result.received = receiver.receive(target, "/table.csv");
+    host.join();
+    result.sentBytes = sender.getBytes();
+    result.receivedBytes = receiver.getBytes();
+    result.output = target.contents("/table.csv");
+    return result;
+}
+
+static uint16_t crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0;
+    while (size--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// Raw 128 byte block as a foreign sender would put it on the line
+static void writeBlock(Stream& out, uint8_t seq, const uint8_t* data) {
+    uint8_t frame[3 + 128 + 2] = { 0x01, seq, (uint8_t)~seq };
+    memcpy(frame + 3, data, 128);
+    uint16_t crc = crc16(data, 128);
+    frame[131] = crc >> 8;
+    frame[132] = crc & 0xFF;
+    out.write(frame, sizeof(frame));
+}
+
+static int expectByte(Stream& in) {
+    unsigned long start = millis();
+    while (!in.available() && millis() - start < 3000) {
+        delay(1);
+    }
+    return in.read();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_round_trip_full_blocks() {
+    std::string input = pattern(3 * YMODEM_BLOCK_SIZE);
+    RoundTrip result = roundTrip(input);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.sent);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.received);
+    TEST_ASSERT_EQUAL(input.size(), result.sentBytes);
+    TEST_ASSERT_EQUAL(input.size(), result.receivedBytes);
+    TEST_ASSERT_TRUE(result.output == input);
+}
+
+// The padding of the last 1K block is stripped using the header size
+void test_round_trip_short_final_block() {
+    std::string input = pattern(2 * YMODEM_BLOCK_SIZE + 700);
+    RoundTrip result = roundTrip(input);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.received);
+    TEST_ASSERT_EQUAL(input.size(), result.receivedBytes);
+    TEST_ASSERT_TRUE(result.output == input);
+}
+
+// A final block of 128 bytes or less goes out as a small SOH block
+void test_round_trip_small_final_block() {
+    std::string input = pattern(YMODEM_BLOCK_SIZE + 50);
+    RoundTrip result = roundTrip(input);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.received);
+    TEST_ASSERT_TRUE(result.output == input);
+}
+
+void test_round_trip_empty_file() {
+    RoundTrip result = roundTrip("");
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.sent);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.received);
+    TEST_ASSERT_EQUAL(0, result.output.size());
+}
+
+// One damaged byte in the first data block: NAK, resend, same result
+void test_crc_error_is_retried() {
+    std::string input = pattern(2 * YMODEM_BLOCK_SIZE + 10);
+    // Header block is 133 bytes, the first data block starts after it
+    const size_t damaged = 133 + 3 + 100;
+    RoundTrip result = roundTrip(input, [damaged](size_t offset) { return offset == damaged; });
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.sent);
+    TEST_ASSERT_EQUAL(TransferResult::OK, result.received);
+    TEST_ASSERT_TRUE(result.output == input);
+}
+
+// A line that damages every block ends both sides with an error
+void test_persistent_crc_errors_abort() {
+    std::string input = pattern(YMODEM_BLOCK_SIZE);
+    RoundTrip result = roundTrip(input, [](size_t offset) { return offset > 133 && offset % 97 == 0; });
+    TEST_ASSERT_EQUAL(TransferResult::BAD_BLOCK, result.received);
+    TEST_ASSERT_TRUE(result.sent != TransferResult::OK);
+}
+
+// A file name filling the whole header block leaves no size field; the
+// receiver must not parse past the block into the rest of the frame
+void test_header_without_size_field() {
+    Link link;
+    LinkEnd peer(link, true);
+    LinkEnd device(link, false);
+    fs::FS target;
+
+    // Leftover digit right after the header block in the frame buffer
+    static uint8_t frame[YMODEM_FRAME_SIZE];
+    memset(frame, 'x', sizeof(frame));
+    memcpy(frame + 3 + 128 + 2, "0;", 2);
+
+    // Name whose CRC low byte is '5': reading on past the block would find
+    // "50" and cut the data block short
+    uint8_t header[128];
+    memset(header, 'n', sizeof(header));
+    for (int i = 0; (crc16(header, 128) & 0xFF) != '5'; i++) {
+        header[126] = 'a' + i / 26;
+        header[127] = 'a' + i % 26;
+    }
+
+    TransferResult received;
+    std::thread receiving([&]() {
+        Ymodem receiver(device, frame);
+        received = receiver.receive(target, "/long.bin");
+    });
+
+    uint8_t data[128];
+    memset(data, 'd', sizeof(data));
+    uint8_t end[128] = {};
+    TEST_ASSERT_EQUAL('C', expectByte(peer));
+    writeBlock(peer, 0, header);
+    TEST_ASSERT_EQUAL(0x06, expectByte(peer));
+    TEST_ASSERT_EQUAL('C', expectByte(peer));
+    writeBlock(peer, 1, data);
+    TEST_ASSERT_EQUAL(0x06, expectByte(peer));
+    peer.write((uint8_t)0x04);
+    TEST_ASSERT_EQUAL(0x15, expectByte(peer));
+    peer.write((uint8_t)0x04);
+    TEST_ASSERT_EQUAL(0x06, expectByte(peer));
+    TEST_ASSERT_EQUAL('C', expectByte(peer));
+    writeBlock(peer, 0, end);
+    TEST_ASSERT_EQUAL(0x06, expectByte(peer));
+    receiving.join();
+
+    // Unknown size: the whole block is kept
+    TEST_ASSERT_EQUAL(TransferResult::OK, received);
+    TEST_ASSERT_EQUAL(128, target.contents("/long.bin").size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_full_blocks);
+    RUN_TEST(test_round_trip_short_final_block);
+    RUN_TEST(test_round_trip_small_final_block);
+    RUN_TEST(test_round_trip_empty_file);
+    RUN_TEST(test_crc_error_is_retried);
+    RUN_TEST(test_persistent_crc_errors_abort);
+    RUN_TEST(test_header_without_size_field);
+    return UNITY_END();
+}